@@ -1,6 +1,6 @@
 @echo off
 echo Compilando proyecto Octree...
-g++ -std=c++17 -O2 main.cpp -o octree_demo.exe
+g++ -std=c++17 -O2 -pthread main.cpp -o octree_demo.exe
 if %ERRORLEVEL% EQU 0 (
     echo.
     echo Compilacion exitosa!
@@ -9,6 +9,29 @@
 #include <chrono>
 #include <iomanip>
 #include <sstream>
+#include <unordered_map>
+#include <list>
+#include <deque>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <queue>
+#include <functional>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
 
 using namespace std;
 using namespace std::chrono;
@@ -84,6 +107,32 @@ struct BoundingBox {
     double volume() const {
         return (max.x - min.x) * (max.y - min.y) * (max.z - min.z);
     }
+
+    // Distancia al cuadrado desde un punto a la caja (0 si esta dentro)
+    double distanceSquared(const Point& p) const {
+        double dx = std::max(0.0, std::max(min.x - p.x, p.x - max.x));
+        double dy = std::max(0.0, std::max(min.y - p.y, p.y - max.y));
+        double dz = std::max(0.0, std::max(min.z - p.z, p.z - max.z));
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    Point center() const {
+        return Point((min.x + max.x) / 2.0, (min.y + max.y) / 2.0, (min.z + max.z) / 2.0);
+    }
+
+    // Octante (0-7) de un punto respecto al centro
+    // Codificacion binaria: bit 2 = x, bit 1 = y, bit 0 = z (el centro va arriba)
+    int octantOf(const Point& p) const {
+        Point mid = center();
+        return (p.x >= mid.x ? 4 : 0) | (p.y >= mid.y ? 2 : 0) | (p.z >= mid.z ? 1 : 0);
+    }
+
+    // Caja del octante i, con la misma codificacion que octantOf
+    BoundingBox octant(int i) const {
+        Point mid = center();
+        return BoundingBox(Point((i & 4) ? mid.x : min.x, (i & 2) ? mid.y : min.y, (i & 1) ? mid.z : min.z),
+                           Point((i & 4) ? max.x : mid.x, (i & 2) ? max.y : mid.y, (i & 1) ? max.z : mid.z));
+    }
 };
 
 // =============================================================================
@@ -96,8 +145,11 @@ public:
     unique_ptr<OctreeNode> children[8];
     bool is_leaf;
     int depth;
+    int depthLimit;       // Profundidad maxima de este subarbol (por defecto MAX_DEPTH)
+    int leafCapacity;     // Puntos por hoja antes de subdividir (por defecto THRESHOLD)
 
-    OctreeNode(const BoundingBox& b, int d) : bounds(b), is_leaf(true), depth(d) {
+    OctreeNode(const BoundingBox& b, int d, int maxDepth = MAX_DEPTH, int threshold = THRESHOLD)
+        : bounds(b), is_leaf(true), depth(d), depthLimit(maxDepth), leafCapacity(threshold) {
         for (int i = 0; i < 8; ++i) children[i] = nullptr;
     }
 
@@ -107,12 +159,26 @@ public:
     // Complejidad: O(cbrt(n) + k) donde k es el numero de puntos en el rango
     void rangeQuery(const BoundingBox& range, vector<Point>& result) const;
 
+    // Los k puntos mas cercanos a q, ordenados por distancia (busqueda best-first)
+    // Complejidad: O(log n + k log k) promedio
+    void kNearest(const Point& q, int k, vector<Point>& result) const;
+
     // Determina en que octante (0-7) esta un punto
     int determineOctant(const Point& p) const;
 
+    // Localiza la hoja que contiene un punto (nullptr si esta fuera de los limites)
+    const OctreeNode* findLeaf(const Point& p) const;
+
     // Obtiene estadisticas del arbol
     void getStats(int& totalNodes, int& leafNodes, int& maxDepth, int& totalPoints) const;
 
+    // Cambia los limites de este nodo; los hijos creados despues los heredan
+    void setLimits(int maxDepth, int threshold);
+
+    // Subdivide hasta targetDepth aunque no haya puntos, para poder asignar
+    // limites distintos a cada region
+    void splitTo(int targetDepth);
+
 private:
     void subdivide();
 };
@@ -122,40 +188,15 @@ private:
 // =============================================================================
 
 int OctreeNode::determineOctant(const Point& p) const {
-    int octant = 0;
-    double midX = (bounds.min.x + bounds.max.x) / 2.0;
-    double midY = (bounds.min.y + bounds.max.y) / 2.0;
-    double midZ = (bounds.min.z + bounds.max.z) / 2.0;
-
-    // Codificacion binaria: bit 2 = x, bit 1 = y, bit 0 = z
-    if (p.x >= midX) octant |= 4;
-    if (p.y >= midY) octant |= 2;
-    if (p.z >= midZ) octant |= 1;
-
-    return octant;
+    return bounds.octantOf(p);
 }
 
 void OctreeNode::subdivide() {
     if (!is_leaf) return;
 
-    double midX = (bounds.min.x + bounds.max.x) / 2.0;
-    double midY = (bounds.min.y + bounds.max.y) / 2.0;
-    double midZ = (bounds.min.z + bounds.max.z) / 2.0;
-
     // Crear 8 nodos hijos
     for (int i = 0; i < 8; ++i) {
-        double subMinX = (i & 4) ? midX : bounds.min.x;
-        double subMinY = (i & 2) ? midY : bounds.min.y;
-        double subMinZ = (i & 1) ? midZ : bounds.min.z;
-
-        double subMaxX = (i & 4) ? bounds.max.x : midX;
-        double subMaxY = (i & 2) ? bounds.max.y : midY;
-        double subMaxZ = (i & 1) ? bounds.max.z : midZ;
-
-        Point subMin(subMinX, subMinY, subMinZ);
-        Point subMax(subMaxX, subMaxY, subMaxZ);
-
-        children[i] = make_unique<OctreeNode>(BoundingBox(subMin, subMax), depth + 1);
+        children[i] = make_unique<OctreeNode>(bounds.octant(i), depth + 1, depthLimit, leafCapacity);
     }
 
     // Redistribuir puntos a los hijos
@@ -172,7 +213,7 @@ void OctreeNode::insert(const Point& p) {
     if (!bounds.contains(p)) return;
 
     if (is_leaf) {
-        if (depth >= MAX_DEPTH || points.size() < THRESHOLD) {
+        if (depth >= depthLimit || points.size() < (size_t)leafCapacity) {
             points.push_back(p);
             return;
         } else {
@@ -211,523 +252,3823 @@ void OctreeNode::rangeQuery(const BoundingBox& range, vector<Point>& result) con
     }
 }
 
-void OctreeNode::getStats(int& totalNodes, int& leafNodes, int& maxDepth, int& totalPoints) const {
-    totalNodes++;
-    if (depth > maxDepth) maxDepth = depth;
+void OctreeNode::kNearest(const Point& q, int k, vector<Point>& result) const {
+    if (k <= 0) return;
+
+    auto dist2 = [&q](const Point& p) {
+        return (p.x - q.x) * (p.x - q.x) + (p.y - q.y) * (p.y - q.y) + (p.z - q.z) * (p.z - q.z);
+    };
+
+    // Nodos pendientes ordenados por distancia minima; candidatos en un max-heap
+    using NodeEntry = pair<double, const OctreeNode*>;
+    using Candidate = pair<double, Point>;
+    auto farther = [](const Candidate& a, const Candidate& b) { return a.first < b.first; };
+
+    priority_queue<NodeEntry, vector<NodeEntry>, greater<NodeEntry>> pending;
+    priority_queue<Candidate, vector<Candidate>, decltype(farther)> best(farther);
+    pending.push({bounds.distanceSquared(q), this});
+
+    while (!pending.empty()) {
+        NodeEntry top = pending.top();
+        pending.pop();
+
+        // Ningun nodo restante puede mejorar los k candidatos
+        if ((int)best.size() == k && top.first > best.top().first) break;
+
+        const OctreeNode* node = top.second;
+        if (node->is_leaf) {
+            for (const auto& p : node->points) {
+                double d = dist2(p);
+                if ((int)best.size() < k) {
+                    best.push({d, p});
+                } else if (d < best.top().first) {
+                    best.pop();
+                    best.push({d, p});
+                }
+            }
+            continue;
+        }
 
-    if (is_leaf) {
-        leafNodes++;
-        totalPoints += points.size();
-    } else {
         for (int i = 0; i < 8; ++i) {
-            if (children[i]) {
-                children[i]->getStats(totalNodes, leafNodes, maxDepth, totalPoints);
+            if (node->children[i]) {
+                pending.push({node->children[i]->bounds.distanceSquared(q), node->children[i].get()});
             }
         }
     }
-}
-
-// =============================================================================
-// FUNCIONES DE UTILIDAD Y VISUALIZACION
-// =============================================================================
 
-void printHeader(const string& title) {
-    cout << "\n" << Color::BOLD << Color::CYAN;
-    cout << "=========================================================" << endl;
-    cout << "  " << title << endl;
-    cout << "=========================================================" << Color::RESET << endl;
+    size_t first = result.size();
+    while (!best.empty()) {
+        result.push_back(best.top().second);
+        best.pop();
+    }
+    reverse(result.begin() + first, result.end());
 }
 
-void printSubHeader(const string& title) {
-    cout << "\n" << Color::YELLOW << Color::BOLD << ">>> " << title << Color::RESET << endl;
+void OctreeNode::setLimits(int maxDepth, int threshold) {
+    depthLimit = maxDepth;
+    leafCapacity = threshold;
 }
 
-void printSuccess(const string& message) {
-    cout << Color::GREEN << "[✓] " << message << Color::RESET << endl;
+void OctreeNode::splitTo(int targetDepth) {
+    if (depth >= targetDepth || depth >= depthLimit) return;
+
+    subdivide();
+    for (int i = 0; i < 8; ++i) {
+        if (children[i]) children[i]->splitTo(targetDepth);
+    }
 }
 
-void printInfo(const string& message) {
-    cout << Color::BLUE << "[i] " << message << Color::RESET << endl;
+const OctreeNode* OctreeNode::findLeaf(const Point& p) const {
+    if (!bounds.contains(p)) return nullptr;
+
+    const OctreeNode* node = this;
+    while (!node->is_leaf) {
+        const OctreeNode* child = node->children[node->determineOctant(p)].get();
+        if (!child) break;
+        node = child;
+    }
+    return node;
 }
 
-void printWarning(const string& message) {
-    cout << Color::YELLOW << "[!] " << message << Color::RESET << endl;
+// Recorre cualquier arbol con is_leaf, depth, points y children[8]
+template <typename Node>
+void collectTreeStats(const Node* node, int& totalNodes, int& leafNodes, int& maxDepth, int& totalPoints) {
+    totalNodes++;
+    if (node->depth > maxDepth) maxDepth = node->depth;
+
+    if (node->is_leaf) {
+        leafNodes++;
+        totalPoints += node->points.size();
+    } else {
+        for (int i = 0; i < 8; ++i) {
+            if (node->children[i]) {
+                collectTreeStats(node->children[i].get(), totalNodes, leafNodes, maxDepth, totalPoints);
+            }
+        }
+    }
 }
 
-void printError(const string& message) {
-    cout << Color::RED << "[✗] " << message << Color::RESET << endl;
+void OctreeNode::getStats(int& totalNodes, int& leafNodes, int& maxDepth, int& totalPoints) const {
+    collectTreeStats(this, totalNodes, leafNodes, maxDepth, totalPoints);
 }
 
-// Visualizacion 2D mejorada con estadisticas
-void draw2DProjection(const OctreeNode* root, const vector<Point>& all_points) {
-    double step = 100.0 / GRID_SIZE;
+// =============================================================================
+// CURSOR DE CONSULTA POR RANGO (STREAMING / PAGINACION)
+// =============================================================================
+// Recorre el octree con una pila explicita en lugar de recursion, entregando
+// los puntos de uno en uno. Los hijos se visitan en orden 0..7 (bit 2 = x,
+// bit 1 = y, bit 0 = z), que es el orden Z (Morton), el mismo que rangeQuery.
+// La memoria usada es O(profundidad) sin importar cuantos puntos haya en el rango.
+// Cada nodo puede tener su propio depthLimit, asi que la pila crece con la
+// profundidad real del arbol y no se acota con MAX_DEPTH.
+
+class RangeCursor {
+public:
+    RangeCursor(const OctreeNode* root, const BoundingBox& range, size_t limit = 0);
 
-    printSubHeader("PROYECCION 2D (Plano XY)");
+    // Avanza al siguiente punto dentro del rango. Retorna false si ya no hay mas
+    bool next(Point& out);
 
-    // Estadisticas del octree
-    int totalNodes = 0, leafNodes = 0, maxDepth = 0, totalPoints = 0;
-    root->getStats(totalNodes, leafNodes, maxDepth, totalPoints);
+    // Agrega a 'page' hasta pageSize puntos. Retorna cuantos se agregaron
+    size_t nextPage(vector<Point>& page, size_t pageSize);
 
-    cout << Color::CYAN << "Nodos totales: " << totalNodes
-         << " | Hojas: " << leafNodes
-         << " | Profundidad max: " << maxDepth
-         << " | Puntos: " << totalPoints << Color::RESET << endl;
+    // Termina al agotar el arbol o al alcanzar el limite (0 = sin limite)
+    bool finished() const { return exhausted || (limit > 0 && emitted >= limit); }
+    size_t emittedCount() const { return emitted; }
 
-    cout << "\n  " << Color::WHITE;
-    for(int i = 0; i < GRID_SIZE; ++i) cout << "-";
-    cout << Color::RESET << endl;
+    // Memoria propia del cursor (objeto + pila de recorrido)
+    size_t memoryBytes() const { return sizeof(*this) + stack.capacity() * sizeof(Frame); }
 
-    for (int j = GRID_SIZE - 1; j >= 0; --j) {
-        cout << Color::WHITE << setw(3) << (int)(j * 2.5) << "|" << Color::RESET;
+    // Serializa el estado (rango, limite y camino de octantes) en texto plano.
+    // Solo es valido mientras el octree no se modifique entre paginas.
+    string serialize() const;
 
-        for (int i = 0; i < GRID_SIZE; ++i) {
-            char marker = ' ';
-            double x_start = i * step;
-            double y_start = j * step;
+    // Reconstruye un cursor desde serialize(). Retorna nullptr si el token
+    // es invalido o no corresponde a la estructura actual del arbol.
+    static unique_ptr<RangeCursor> resume(const OctreeNode* root, const string& token);
 
-            int count = 0;
-            for (const auto& p : all_points) {
-                if (p.x >= x_start && p.x < (x_start + step) &&
-                    p.y >= y_start && p.y < (y_start + step)) {
-                    count++;
-                }
-            }
+private:
+    struct Frame {
+        const OctreeNode* node;
+        int next;   // Nodo interno: siguiente hijo; hoja: siguiente punto
+    };
 
-            if (count > 0) {
-                if (count == 1) {
-                    cout << Color::GREEN << "." << Color::RESET;
-                } else if (count <= 3) {
-                    cout << Color::YELLOW << "o" << Color::RESET;
-                } else {
-                    cout << Color::RED << "@" << Color::RESET;
+    const OctreeNode* root;
+    BoundingBox range;
+    size_t limit;
+    size_t emitted;
+    bool exhausted;
+    vector<Frame> stack;
+};
+
+RangeCursor::RangeCursor(const OctreeNode* r, const BoundingBox& q, size_t lim)
+    : root(r), range(q), limit(lim), emitted(0), exhausted(false) {
+    stack.reserve(MAX_DEPTH + 1);           // Solo una sugerencia: arboles mas profundos la hacen crecer
+    if (root && root->bounds.intersects(range)) {
+        stack.push_back({root, 0});
+    } else {
+        exhausted = true;
+    }
+}
+
+bool RangeCursor::next(Point& out) {
+    if (finished()) return false;
+
+    while (!stack.empty()) {
+        Frame& top = stack.back();
+        const OctreeNode* node = top.node;
+
+        if (node->is_leaf) {
+            while (top.next < (int)node->points.size()) {
+                const Point& p = node->points[top.next++];
+                if (range.contains(p)) {
+                    out = p;
+                    emitted++;
+                    return true;
                 }
-            } else {
-                cout << " ";
             }
+            stack.pop_back();
+            continue;
         }
-        cout << Color::WHITE << "|" << Color::RESET << endl;
-    }
 
-    cout << "  ";
-    for(int i = 0; i < GRID_SIZE; ++i) cout << "-";
-    cout << endl;
+        // Nodo interno: bajar al siguiente hijo que interseca el rango
+        const OctreeNode* child = nullptr;
+        while (top.next < 8 && !child) {
+            const OctreeNode* c = node->children[top.next++].get();
+            if (c && c->bounds.intersects(range)) child = c;
+        }
 
-    cout << "  ";
-    for(int i = 0; i < GRID_SIZE; ++i) {
-        if (i % 10 == 0) cout << (int)(i * 2.5);
-        else if (i % 10 == 1 && i > 1) cout << " ";
-        else cout << " ";
+        if (child) {
+            stack.push_back({child, 0});
+        } else {
+            stack.pop_back();
+        }
     }
-    cout << endl;
 
-    cout << "\n" << Color::CYAN << "Leyenda: "
-         << Color::GREEN << "." << Color::RESET << "=1 punto  "
-         << Color::YELLOW << "o" << Color::RESET << "=2-3 puntos  "
-         << Color::RED << "@" << Color::RESET << "=4+ puntos" << endl;
+    exhausted = true;
+    return false;
 }
 
-// Valida que dos vectores contengan los mismos puntos
-bool validateResults(const vector<Point>& v1, const vector<Point>& v2) {
-    if (v1.size() != v2.size()) return false;
+size_t RangeCursor::nextPage(vector<Point>& page, size_t pageSize) {
+    size_t added = 0;
+    Point p;
+    while (added < pageSize && next(p)) {
+        page.push_back(p);
+        added++;
+    }
+    return added;
+}
 
-    vector<Point> sorted1 = v1;
-    vector<Point> sorted2 = v2;
+string RangeCursor::serialize() const {
+    ostringstream out;
+    out << setprecision(17);
+    out << "RC1 " << range.min.x << " " << range.min.y << " " << range.min.z << " "
+        << range.max.x << " " << range.max.y << " " << range.max.z << " "
+        << limit << " " << emitted << " " << (exhausted ? 1 : 0) << " " << stack.size();
+    for (const auto& f : stack) {
+        out << " " << f.next;
+    }
+    return out.str();
+}
 
-    auto comparator = [](const Point& a, const Point& b) {
-        if (a.x != b.x) return a.x < b.x;
-        if (a.y != b.y) return a.y < b.y;
-        return a.z < b.z;
-    };
+unique_ptr<RangeCursor> RangeCursor::resume(const OctreeNode* root, const string& token) {
+    istringstream in(token);
+    string tag;
+    double x1, y1, z1, x2, y2, z2;
+    size_t lim, emitted, depth;
+    int exhausted;
 
-    sort(sorted1.begin(), sorted1.end(), comparator);
-    sort(sorted2.begin(), sorted2.end(), comparator);
+    if (!(in >> tag >> x1 >> y1 >> z1 >> x2 >> y2 >> z2 >> lim >> emitted >> exhausted >> depth)) {
+        return nullptr;
+    }
+    // La profundidad no se acota aqui: el camino se valida contra el arbol real
+    // y falla en cuanto pasa de una hoja
+    if (tag != "RC1" || !root) return nullptr;
+
+    auto cursor = make_unique<RangeCursor>(root, BoundingBox(Point(x1, y1, z1), Point(x2, y2, z2)), lim);
+    cursor->emitted = emitted;
+    cursor->exhausted = (exhausted != 0);
+    cursor->stack.clear();
+
+    // Rehacer el camino: cada marco interno apunta (next - 1) al hijo del siguiente marco
+    const OctreeNode* node = root;
+    for (size_t i = 0; i < depth; ++i) {
+        int next;
+        if (!(in >> next) || !node || next < 0) return nullptr;
+
+        if (node->is_leaf) {
+            if (i + 1 != depth || next > (int)node->points.size()) return nullptr;
+        } else if (next > 8 || (i + 1 < depth && next == 0)) {
+            return nullptr;
+        }
 
-    for (size_t i = 0; i < sorted1.size(); ++i) {
-        if (!(sorted1[i] == sorted2[i])) return false;
+        cursor->stack.push_back({node, next});
+        node = (i + 1 < depth && !node->is_leaf) ? node->children[next - 1].get() : nullptr;
     }
 
-    return true;
+    return cursor;
 }
 
 // =============================================================================
-// ESCENARIOS DE DEMOSTRACION
+// CACHE DE RESULTADOS DE CONSULTA (CAJAS CUANTIZADAS)
 // =============================================================================
+// Capa opcional delante del octree. Cada consulta se expande hacia afuera a una
+// rejilla de tamano 'quantum'; la caja resultante es la llave del cache y guarda
+// los puntos que contiene. Consultas repetidas o ligeramente desplazadas caen en
+// la misma llave y se responden filtrando esos puntos, sin recorrer el arbol.
+// Un insert solo invalida las entradas cuya caja interseca la hoja modificada.
+struct CacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t invalidated = 0;   // Entradas borradas por inserts
+    size_t evicted = 0;       // Entradas borradas por limite de memoria (LRU)
+    size_t bypassed = 0;      // Resultados mas grandes que el limite (no se guardan)
+
+    double hitRate() const {
+        size_t total = hits + misses;
+        return total > 0 ? (double)hits / total : 0.0;
+    }
+};
 
-void scenario1_BasicDemo() {
-    printHeader("ESCENARIO 1: DEMOSTRACION BASICA");
+class QueryCache {
+public:
+    QueryCache(OctreeNode* root, double quantum, size_t maxBytes);
 
-    Point min_world(0.0, 0.0, 0.0);
-    Point max_world(100.0, 100.0, 100.0);
-    BoundingBox world_bounds(min_world, max_world);
+    // Inserta en el octree e invalida las entradas afectadas
+    void insert(const Point& p);
 
-    int N = 1000;
-    OctreeNode root(world_bounds, 0);
-    vector<Point> points;
+    // Mismo resultado que OctreeNode::rangeQuery
+    void rangeQuery(const BoundingBox& range, vector<Point>& result);
 
-    printInfo("Insertando " + to_string(N) + " puntos aleatorios...");
+    // Numero de puntos dentro del rango
+    size_t countQuery(const BoundingBox& range);
 
-    for (int i = 0; i < N; ++i) {
-        double x = (double)rand() / RAND_MAX * 100.0;
-        double y = (double)rand() / RAND_MAX * 100.0;
-        double z = (double)rand() / RAND_MAX * 100.0;
-        Point p(x, y, z);
-        points.push_back(p);
-        root.insert(p);
-    }
+    void clear();
 
-    printSuccess("Puntos insertados correctamente");
-    draw2DProjection(&root, points);
-}
+    const CacheStats& stats() const { return cacheStats; }
+    size_t memoryBytes() const { return usedBytes; }
+    size_t entryCount() const { return entries.size(); }
 
-void scenario2_PerformanceBenchmark() {
-    printHeader("ESCENARIO 2: BENCHMARK DE RENDIMIENTO");
+private:
+    struct Key {
+        long long c[6];
+        bool operator==(const Key& other) const {
+            for (int i = 0; i < 6; ++i) {
+                if (c[i] != other.c[i]) return false;
+            }
+            return true;
+        }
+    };
 
-    Point min_world(0.0, 0.0, 0.0);
-    Point max_world(100.0, 100.0, 100.0);
-    BoundingBox world_bounds(min_world, max_world);
+    struct KeyHash {
+        size_t operator()(const Key& k) const {
+            size_t h = 1469598103934665603ULL;
+            for (int i = 0; i < 6; ++i) {
+                h ^= (size_t)k.c[i];
+                h *= 1099511628211ULL;
+            }
+            return h;
+        }
+    };
 
-    vector<int> testSizes = {10000, 50000, 100000, 200000};
+    struct Entry {
+        BoundingBox box;
+        vector<Point> points;
+        list<Key>::iterator lru;
+        size_t bytes;
+    };
 
-    cout << Color::BOLD << "\nPrueba de escalabilidad con diferentes tamanos de datos:\n" << Color::RESET;
-    cout << setw(12) << "N" << setw(15) << "Octree (ms)" << setw(15) << "Naive (ms)"
-         << setw(15) << "Speedup" << setw(15) << "Puntos" << endl;
-    cout << string(70, '-') << endl;
+    using EntryMap = unordered_map<Key, Entry, KeyHash>;
 
-    for (int N : testSizes) {
-        OctreeNode root(world_bounds, 0);
-        vector<Point> all_points;
+    Key quantize(const BoundingBox& range, BoundingBox& snapped) const;
+    const vector<Point>& fetch(const BoundingBox& range, bool& aligned);
+    EntryMap::iterator erase(EntryMap::iterator it);
 
-        // Generar puntos
-        for (int i = 0; i < N; ++i) {
-            double x = (double)rand() / RAND_MAX * 100.0;
-            double y = (double)rand() / RAND_MAX * 100.0;
-            double z = (double)rand() / RAND_MAX * 100.0;
-            Point p(x, y, z);
-            all_points.push_back(p);
-            root.insert(p);
-        }
+    OctreeNode* root;
+    double quantum;
+    size_t maxBytes;
+    size_t usedBytes;
+    EntryMap entries;
+    list<Key> lru;            // Frente = usado mas recientemente
+    vector<Point> scratch;    // Resultado temporal cuando no se guarda en cache
+    CacheStats cacheStats;
+};
 
-        // Rango de consulta
-        Point min_range(40.0, 40.0, 40.0);
-        Point max_range(60.0, 60.0, 60.0);
-        BoundingBox query_range(min_range, max_range);
+QueryCache::QueryCache(OctreeNode* r, double q, size_t maxB)
+    : root(r), quantum(q), maxBytes(maxB), usedBytes(0) {}
+
+QueryCache::Key QueryCache::quantize(const BoundingBox& range, BoundingBox& snapped) const {
+    Key key;
+    key.c[0] = (long long)floor(range.min.x / quantum);
+    key.c[1] = (long long)floor(range.min.y / quantum);
+    key.c[2] = (long long)floor(range.min.z / quantum);
+    key.c[3] = (long long)ceil(range.max.x / quantum);
+    key.c[4] = (long long)ceil(range.max.y / quantum);
+    key.c[5] = (long long)ceil(range.max.z / quantum);
+
+    // Con un quantum que no es potencia de 2, c * quantum puede caer dentro del
+    // rango (17 * 0.1 > 1.7). Se corre la llave hasta que la caja cubra el rango,
+    // asi la caja depende solo de la llave y contiene toda consulta que la produce
+    const double lo[3] = {range.min.x, range.min.y, range.min.z};
+    const double hi[3] = {range.max.x, range.max.y, range.max.z};
+    for (int i = 0; i < 3; ++i) {
+        while (key.c[i] * quantum > lo[i]) key.c[i]--;
+        while (key.c[i + 3] * quantum < hi[i]) key.c[i + 3]++;
+    }
 
-        // Benchmark Octree
-        vector<Point> octree_results;
-        auto start_octree = high_resolution_clock::now();
-        root.rangeQuery(query_range, octree_results);
-        auto end_octree = high_resolution_clock::now();
-        auto time_octree = duration_cast<microseconds>(end_octree - start_octree).count();
+    snapped.min = Point(key.c[0] * quantum, key.c[1] * quantum, key.c[2] * quantum);
+    snapped.max = Point(key.c[3] * quantum, key.c[4] * quantum, key.c[5] * quantum);
+    return key;
+}
 
-        // Benchmark Naive
-        vector<Point> naive_results;
-        auto start_naive = high_resolution_clock::now();
-        for (const auto& p : all_points) {
-            if (query_range.contains(p)) {
-                naive_results.push_back(p);
-            }
-        }
-        auto end_naive = high_resolution_clock::now();
-        auto time_naive = duration_cast<microseconds>(end_naive - start_naive).count();
+const vector<Point>& QueryCache::fetch(const BoundingBox& range, bool& aligned) {
+    BoundingBox snapped(range.min, range.max);
+    Key key = quantize(range, snapped);
 
-        double speedup = (double)time_naive / max(1.0, (double)time_octree);
+    // Si la consulta ya esta alineada a la rejilla no hace falta filtrar
+    aligned = (snapped.min.x == range.min.x && snapped.min.y == range.min.y &&
+               snapped.min.z == range.min.z && snapped.max.x == range.max.x &&
+               snapped.max.y == range.max.y && snapped.max.z == range.max.z);
 
-        cout << setw(12) << N
-             << setw(15) << fixed << setprecision(2) << time_octree / 1000.0
-             << setw(15) << time_naive / 1000.0
-             << setw(14) << setprecision(1) << speedup << "x"
-             << setw(15) << octree_results.size() << endl;
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        cacheStats.hits++;
+        lru.splice(lru.begin(), lru, it->second.lru);
+        return it->second.points;
     }
-}
 
-void scenario3_ValidationTest() {
-    printHeader("ESCENARIO 3: VALIDACION DE CORRECTITUD");
+    cacheStats.misses++;
+    vector<Point> points;
+    root->rangeQuery(snapped, points);
 
-    Point min_world(0.0, 0.0, 0.0);
-    Point max_world(100.0, 100.0, 100.0);
-    BoundingBox world_bounds(min_world, max_world);
+    size_t bytes = sizeof(Entry) + sizeof(Key) + points.capacity() * sizeof(Point);
+    if (bytes > maxBytes) {
+        cacheStats.bypassed++;
+        scratch = move(points);
+        return scratch;
+    }
 
-    int N = 50000;
-    OctreeNode root(world_bounds, 0);
-    vector<Point> all_points;
+    while (usedBytes + bytes > maxBytes && !lru.empty()) {
+        erase(entries.find(lru.back()));
+        cacheStats.evicted++;
+    }
 
-    printInfo("Generando " + to_string(N) + " puntos de prueba...");
+    lru.push_front(key);
+    usedBytes += bytes;
+    auto inserted = entries.emplace(key, Entry{snapped, move(points), lru.begin(), bytes});
+    return inserted.first->second.points;
+}
 
-    for (int i = 0; i < N; ++i) {
-        double x = (double)rand() / RAND_MAX * 100.0;
+QueryCache::EntryMap::iterator QueryCache::erase(EntryMap::iterator it) {
+    usedBytes -= it->second.bytes;
+    lru.erase(it->second.lru);
+    return entries.erase(it);
+}
+
+void QueryCache::insert(const Point& p) {
+    root->insert(p);
+
+    const OctreeNode* leaf = root->findLeaf(p);
+    if (!leaf) return;
+
+    for (auto it = entries.begin(); it != entries.end(); ) {
+        if (it->second.box.intersects(leaf->bounds)) {
+            it = erase(it);
+            cacheStats.invalidated++;
+        } else {
+            ++it;
+        }
+    }
+}
+
+void QueryCache::rangeQuery(const BoundingBox& range, vector<Point>& result) {
+    bool aligned;
+    const vector<Point>& cached = fetch(range, aligned);
+
+    if (aligned) {
+        result.insert(result.end(), cached.begin(), cached.end());
+        return;
+    }
+    for (const auto& p : cached) {
+        if (range.contains(p)) {
+            result.push_back(p);
+        }
+    }
+}
+
+size_t QueryCache::countQuery(const BoundingBox& range) {
+    bool aligned;
+    const vector<Point>& cached = fetch(range, aligned);
+
+    if (aligned) return cached.size();
+    return count_if(cached.begin(), cached.end(),
+                    [&range](const Point& p) { return range.contains(p); });
+}
+
+void QueryCache::clear() {
+    entries.clear();
+    lru.clear();
+    scratch.clear();
+    usedBytes = 0;
+}
+
+// =============================================================================
+// SUBMUESTREO POR VOXELES Y ESTADISTICAS POR CELDA (PARALELO)
+// =============================================================================
+// Los voxeles forman una rejilla de lado s desde world.min. Un nodo del octree
+// que cae completo dentro de una celda se acumula entero sin mirar la celda de
+// cada punto; si no, se desciende y las hojas que cruzan bordes agrupan sus
+// puntos por celda. El trabajo se reparte por subarboles entre hilos;
+// como una celda puede cruzar varios subarboles, las sumas parciales de cada
+// hilo se combinan al final.
+const int VOXEL_SPLIT_DEPTH = 3;      // Profundidad de corte para repartir tareas
+const int VOXEL_KEY_BITS = 21;        // 21 bits por eje en la llave del voxel
+
+struct VoxelStats {
+    int ix, iy, iz;                   // Indice de la celda en la rejilla
+    size_t count;
+    Point centroid;
+    double cov[6];                    // Covarianza: xx, xy, xz, yy, yz, zz
+    Point normal;                     // Vector propio del menor valor propio
+};
+
+struct VoxelGridSpec {
+    Point origin;
+    double cell;                      // Lado real de la celda
+    int cellsX, cellsY, cellsZ;       // La ultima celda de cada eje puede quedar recortada
+};
+
+// Vector propio del menor valor propio de una matriz simetrica 3x3 (Jacobi)
+Point smallestEigenvector(const double cov[6]) {
+    double a[3][3] = {{cov[0], cov[1], cov[2]},
+                      {cov[1], cov[3], cov[4]},
+                      {cov[2], cov[4], cov[5]}};
+    double v[3][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+
+    for (int sweep = 0; sweep < 16; ++sweep) {
+        double off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+        if (off < 1e-30) break;
+
+        for (int p = 0; p < 2; ++p) {
+            for (int q = p + 1; q < 3; ++q) {
+                if (a[p][q] == 0.0) continue;
+
+                double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                double t = (theta >= 0 ? 1.0 : -1.0) / (abs(theta) + sqrt(theta * theta + 1.0));
+                double c = 1.0 / sqrt(t * t + 1.0);
+                double s = t * c;
+
+                for (int k = 0; k < 3; ++k) {
+                    double akp = a[k][p], akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < 3; ++k) {
+                    double apk = a[p][k], aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < 3; ++k) {
+                    double vkp = v[k][p], vkq = v[k][q];
+                    v[k][p] = c * vkp - s * vkq;
+                    v[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+
+    int m = 0;
+    for (int i = 1; i < 3; ++i) {
+        if (a[i][i] < a[m][m]) m = i;
+    }
+    return Point(v[0][m], v[1][m], v[2][m]);
+}
+
+// Sumas de primer y segundo orden de los puntos de un voxel
+// Las sumas se acumulan relativas al primer punto del voxel: con coordenadas
+// grandes (p.ej. 1e6) sxx/n - mx*mx perderia casi todos los digitos por cancelacion
+struct VoxelAccumulator {
+    size_t n = 0;
+    Point ref;
+    double sx = 0, sy = 0, sz = 0;
+    double sxx = 0, sxy = 0, sxz = 0, syy = 0, syz = 0, szz = 0;
+
+    void add(const Point& p) {
+        if (n == 0) ref = p;
+        n++;
+        double dx = p.x - ref.x, dy = p.y - ref.y, dz = p.z - ref.z;
+        sx += dx; sy += dy; sz += dz;
+        sxx += dx * dx; sxy += dx * dy; sxz += dx * dz;
+        syy += dy * dy; syz += dy * dz; szz += dz * dz;
+    }
+
+    // Combina otra acumulacion de la misma celda trasladando sus sumas a esta referencia
+    void merge(const VoxelAccumulator& o) {
+        if (o.n == 0) return;
+        if (n == 0) {
+            *this = o;
+            return;
+        }
+        double dx = o.ref.x - ref.x, dy = o.ref.y - ref.y, dz = o.ref.z - ref.z;
+        double m = (double)o.n;
+        sxx += o.sxx + 2.0 * dx * o.sx + m * dx * dx;
+        syy += o.syy + 2.0 * dy * o.sy + m * dy * dy;
+        szz += o.szz + 2.0 * dz * o.sz + m * dz * dz;
+        sxy += o.sxy + dx * o.sy + dy * o.sx + m * dx * dy;
+        sxz += o.sxz + dx * o.sz + dz * o.sx + m * dx * dz;
+        syz += o.syz + dy * o.sz + dz * o.sy + m * dy * dz;
+        sx += o.sx + m * dx;
+        sy += o.sy + m * dy;
+        sz += o.sz + m * dz;
+        n += o.n;
+    }
+
+    VoxelStats finish(int ix, int iy, int iz) const {
+        VoxelStats v;
+        v.ix = ix; v.iy = iy; v.iz = iz;
+        v.count = n;
+
+        double mx = sx / n, my = sy / n, mz = sz / n;
+        v.centroid = Point(ref.x + mx, ref.y + my, ref.z + mz);
+        v.cov[0] = sxx / n - mx * mx;
+        v.cov[1] = sxy / n - mx * my;
+        v.cov[2] = sxz / n - mx * mz;
+        v.cov[3] = syy / n - my * my;
+        v.cov[4] = syz / n - my * mz;
+        v.cov[5] = szz / n - mz * mz;
+
+        // Con menos de 3 puntos no hay plano definido
+        v.normal = (n >= 3) ? smallestEigenvector(v.cov) : Point(0, 0, 0);
+        return v;
+    }
+};
+
+// Rejilla de lado voxelSize. Solo si el mundo necesitara mas de 2^21 celdas por
+// eje se agranda la celda; grid.cell es siempre el tamano usado
+VoxelGridSpec makeVoxelGrid(const BoundingBox& world, double voxelSize) {
+    double extent = max(world.max.x - world.min.x,
+                        max(world.max.y - world.min.y, world.max.z - world.min.z));
+    const double maxCells = (double)(1 << VOXEL_KEY_BITS);
+
+    VoxelGridSpec grid;
+    grid.origin = world.min;
+    grid.cell = max(voxelSize, extent / maxCells);
+    grid.cellsX = max(1, (int)min(maxCells, ceil((world.max.x - world.min.x) / grid.cell)));
+    grid.cellsY = max(1, (int)min(maxCells, ceil((world.max.y - world.min.y) / grid.cell)));
+    grid.cellsZ = max(1, (int)min(maxCells, ceil((world.max.z - world.min.z) / grid.cell)));
+    return grid;
+}
+
+// Igual a floor() recortado a [0, cells): al recortar antes, el truncado basta
+int voxelIndex(double v, double origin, double cell, int cells) {
+    double f = (v - origin) / cell;
+    if (f < 1.0) return 0;
+    if (f >= cells) return cells - 1;
+    return (int)f;
+}
+
+uint64_t packVoxelKey(int ix, int iy, int iz) {
+    return ((uint64_t)ix << 42) | ((uint64_t)iy << 21) | (uint64_t)iz;
+}
+
+uint64_t voxelKeyOf(const Point& p, const VoxelGridSpec& grid) {
+    return packVoxelKey(voxelIndex(p.x, grid.origin.x, grid.cell, grid.cellsX),
+                        voxelIndex(p.y, grid.origin.y, grid.cell, grid.cellsY),
+                        voxelIndex(p.z, grid.origin.z, grid.cell, grid.cellsZ));
+}
+
+// Celdas [lo, hi] que cubre un intervalo [a, b) de un eje. Los puntos de un nodo
+// estan en [min, max) salvo en el borde superior del mundo, donde voxelIndex
+// recorta igual; por eso basta con el double anterior a b
+void voxelSpan(double a, double b, double origin, double cell, int cells, int& lo, int& hi) {
+    lo = voxelIndex(a, origin, cell, cells);
+    hi = voxelIndex(nextafter(b, a), origin, cell, cells);
+}
+
+void accumulateSubtree(const OctreeNode* node, VoxelAccumulator& acc) {
+    if (node->is_leaf) {
+        for (const auto& p : node->points) acc.add(p);
+        return;
+    }
+    for (int i = 0; i < 8; ++i) {
+        if (node->children[i]) accumulateSubtree(node->children[i].get(), acc);
+    }
+}
+
+// Celdas que cubre una tarea. Si el subarbol abarca pocas celdas se usa un
+// arreglo denso (sin hash por punto); si no, una tabla hash
+const size_t VOXEL_DENSE_CELLS = 1 << 15;
+
+class VoxelCells {
+public:
+    VoxelCells(const int lo[3], const int hi[3]) {
+        size_t total = 1;
+        for (int a = 0; a < 3; ++a) {
+            base[a] = lo[a];
+            dim[a] = hi[a] - lo[a] + 1;
+            total *= (size_t)dim[a];
+        }
+        if (total <= VOXEL_DENSE_CELLS) dense.resize(total);
+    }
+
+    VoxelAccumulator& at(int ix, int iy, int iz) {
+        if (!dense.empty()) {
+            return dense[((size_t)(ix - base[0]) * dim[1] + (iy - base[1])) * dim[2] + (iz - base[2])];
+        }
+        return sparse[packVoxelKey(ix, iy, iz)];
+    }
+
+    // Celdas no vacias con su llave
+    void emit(vector<pair<uint64_t, VoxelAccumulator>>& out) const {
+        for (size_t i = 0; i < dense.size(); ++i) {
+            if (dense[i].n == 0) continue;
+            int iz = (int)(i % dim[2]), iy = (int)(i / dim[2] % dim[1]), ix = (int)(i / dim[2] / dim[1]);
+            out.push_back({packVoxelKey(base[0] + ix, base[1] + iy, base[2] + iz), dense[i]});
+        }
+        for (const auto& kv : sparse) out.push_back(kv);
+    }
+
+private:
+    int base[3], dim[3];
+    vector<VoxelAccumulator> dense;
+    unordered_map<uint64_t, VoxelAccumulator> sparse;
+};
+
+// lo/hi: rango de celdas por eje que cubre el nodo (calculado por el padre)
+void collectVoxels(const OctreeNode* node, const VoxelGridSpec& grid, const int lo[3], const int hi[3],
+                   VoxelCells& out) {
+    // Nodo dentro de una sola celda: todo el subarbol se acumula sin mirar cada punto
+    if (lo[0] == hi[0] && lo[1] == hi[1] && lo[2] == hi[2]) {
+        accumulateSubtree(node, out.at(lo[0], lo[1], lo[2]));
+        return;
+    }
+
+    // Hoja que cruza bordes de celda: cada punto va a su celda
+    if (node->is_leaf) {
+        for (const auto& p : node->points) {
+            out.at(voxelIndex(p.x, grid.origin.x, grid.cell, grid.cellsX),
+                   voxelIndex(p.y, grid.origin.y, grid.cell, grid.cellsY),
+                   voxelIndex(p.z, grid.origin.z, grid.cell, grid.cellsZ)).add(p);
+        }
+        return;
+    }
+
+    // Rangos de los hijos: mitad inferior [min, mid) y superior [mid, max) por eje
+    Point center = node->bounds.center();
+    double mid[3] = {center.x, center.y, center.z};
+    double origin[3] = {grid.origin.x, grid.origin.y, grid.origin.z};
+    int cells[3] = {grid.cellsX, grid.cellsY, grid.cellsZ};
+    int lowerHi[3], upperLo[3];
+    for (int a = 0; a < 3; ++a) {
+        upperLo[a] = voxelIndex(mid[a], origin[a], grid.cell, cells[a]);
+        lowerHi[a] = voxelIndex(nextafter(mid[a], -numeric_limits<double>::infinity()), origin[a], grid.cell, cells[a]);
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        if (!node->children[i]) continue;
+        int childLo[3], childHi[3];
+        for (int a = 0; a < 3; ++a) {
+            bool upper = (i >> (2 - a)) & 1;
+            childLo[a] = upper ? upperLo[a] : lo[a];
+            childHi[a] = upper ? hi[a] : lowerHi[a];
+        }
+        collectVoxels(node->children[i].get(), grid, childLo, childHi, out);
+    }
+}
+
+// Reune en orden Z los subarboles que se reparten entre los hilos
+void gatherSubtrees(const OctreeNode* node, int splitDepth, vector<const OctreeNode*>& tasks) {
+    if (node->is_leaf || node->depth >= splitDepth) {
+        tasks.push_back(node);
+        return;
+    }
+    for (int i = 0; i < 8; ++i) {
+        if (node->children[i]) gatherSubtrees(node->children[i].get(), splitDepth, tasks);
+    }
+}
+
+// Complejidad: O(n / hilos + voxeles)
+vector<VoxelStats> voxelStatistics(const OctreeNode& root, double voxelSize, int numThreads) {
+    VoxelGridSpec grid = makeVoxelGrid(root.bounds, voxelSize);
+
+    vector<const OctreeNode*> tasks;
+    gatherSubtrees(&root, VOXEL_SPLIT_DEPTH, tasks);
+
+    vector<vector<pair<uint64_t, VoxelAccumulator>>> partial(tasks.size());
+    atomic<size_t> nextTask(0);
+
+    auto worker = [&]() {
+        size_t i;
+        while ((i = nextTask++) < tasks.size()) {
+            const BoundingBox& b = tasks[i]->bounds;
+            int lo[3], hi[3];
+            voxelSpan(b.min.x, b.max.x, grid.origin.x, grid.cell, grid.cellsX, lo[0], hi[0]);
+            voxelSpan(b.min.y, b.max.y, grid.origin.y, grid.cell, grid.cellsY, lo[1], hi[1]);
+            voxelSpan(b.min.z, b.max.z, grid.origin.z, grid.cell, grid.cellsZ, lo[2], hi[2]);
+
+            VoxelCells cells(lo, hi);
+            collectVoxels(tasks[i], grid, lo, hi, cells);
+            cells.emit(partial[i]);
+        }
+    };
+
+    vector<thread> pool;
+    for (int t = 1; t < numThreads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+
+    // Combinar las celdas que cruzan subarboles; el orden estable hace que el
+    // resultado no dependa del numero de hilos
+    vector<pair<uint64_t, VoxelAccumulator>> all;
+    for (auto& part : partial) {
+        all.insert(all.end(), part.begin(), part.end());
+    }
+    stable_sort(all.begin(), all.end(),
+                [](const pair<uint64_t, VoxelAccumulator>& a, const pair<uint64_t, VoxelAccumulator>& b) {
+                    return a.first < b.first;
+                });
+
+    vector<VoxelStats> result;
+    for (size_t i = 0; i < all.size(); ) {
+        uint64_t key = all[i].first;
+        VoxelAccumulator acc = all[i++].second;
+        while (i < all.size() && all[i].first == key) acc.merge(all[i++].second);
+        result.push_back(acc.finish((int)(key >> 42), (int)((key >> 21) & 0x1FFFFF), (int)(key & 0x1FFFFF)));
+    }
+    return result;
+}
+
+// Reemplaza los puntos de cada voxel por su centroide
+vector<Point> voxelDownsample(const OctreeNode& root, double voxelSize, int numThreads) {
+    vector<Point> centroids;
+    for (const auto& v : voxelStatistics(root, voxelSize, numThreads)) {
+        centroids.push_back(v.centroid);
+    }
+    return centroids;
+}
+
+unique_ptr<OctreeNode> voxelDownsampleTree(const OctreeNode& root, double voxelSize, int numThreads) {
+    auto tree = make_unique<OctreeNode>(root.bounds, 0);
+    for (const auto& p : voxelDownsample(root, voxelSize, numThreads)) {
+        tree->insert(p);
+    }
+    return tree;
+}
+
+// Referencia: rejilla de voxeles con std::unordered_map (misma rejilla que el octree)
+vector<VoxelStats> voxelStatisticsHashGrid(const vector<Point>& points, const BoundingBox& world, double voxelSize) {
+    VoxelGridSpec grid = makeVoxelGrid(world, voxelSize);
+    unordered_map<uint64_t, VoxelAccumulator> cells;
+
+    for (const auto& p : points) {
+        if (!world.contains(p)) continue;
+        cells[voxelKeyOf(p, grid)].add(p);
+    }
+
+    vector<VoxelStats> result;
+    result.reserve(cells.size());
+    for (const auto& kv : cells) {
+        uint64_t key = kv.first;
+        result.push_back(kv.second.finish((int)(key >> 42), (int)((key >> 21) & 0x1FFFFF), (int)(key & 0x1FFFFF)));
+    }
+    return result;
+}
+
+// =============================================================================
+// OCTREE CON VENTANA DE TIEMPO (PUNTOS CON MARCA TEMPORAL)
+// =============================================================================
+// Igual que OctreeNode, pero cada punto lleva su instante y cada nodo guarda el
+// rango [minTime, maxTime] de su subarbol. Las consultas podan por espacio y por
+// tiempo. Como las hojas son solo espaciales, cada una mezcla instantes de toda
+// la ventana y casi nunca expira entera; por eso TemporalOctree reparte los
+// puntos en epocas de duracion fija, cada una con su propio TemporalOctreeNode,
+// y expirar lo anterior a t descarta epocas completas. Solo la epoca que cruza
+// t se filtra por dentro.
+struct TimedPoint {
+    Point pos;
+    double time;
+    TimedPoint(const Point& p = Point(), double t = 0.0) : pos(p), time(t) {}
+};
+
+struct ExpiryStats {
+    size_t droppedEpochs = 0;     // Epocas descartadas completas
+    size_t epochPoints = 0;       // Puntos eliminados junto con esas epocas
+    size_t droppedSubtrees = 0;   // Subarboles descartados dentro de la epoca que cruza t
+    size_t droppedPoints = 0;     // Puntos eliminados junto con esos subarboles
+    size_t removedPoints = 0;     // Puntos eliminados uno a uno en hojas mixtas
+};
+
+class TemporalOctreeNode {
+public:
+    BoundingBox bounds;
+    vector<TimedPoint> points;
+    unique_ptr<TemporalOctreeNode> children[8];
+    bool is_leaf;
+    int depth;
+    size_t count;                 // Puntos en todo el subarbol
+    double minTime, maxTime;
+
+    TemporalOctreeNode(const BoundingBox& b, int d)
+        : bounds(b), is_leaf(true), depth(d), count(0),
+          minTime(numeric_limits<double>::infinity()),
+          maxTime(-numeric_limits<double>::infinity()) {}
+
+    // Complejidad: O(log n) promedio
+    void insert(const TimedPoint& p);
+
+    // Puntos dentro del rango espacial con time en [t0, t1]
+    void rangeQuery(const BoundingBox& range, double t0, double t1, vector<TimedPoint>& result) const;
+
+    // Elimina los puntos con time < t
+    void expireBefore(double t, ExpiryStats& stats);
+
+    void getStats(int& totalNodes, int& leafNodes, int& maxDepth, int& totalPoints) const;
+
+private:
+    void subdivide();
+    void collectPoints(vector<TimedPoint>& out) const;
+    void refresh();
+};
+
+void TemporalOctreeNode::subdivide() {
+    if (!is_leaf) return;
+
+    for (int i = 0; i < 8; ++i) {
+        children[i] = make_unique<TemporalOctreeNode>(bounds.octant(i), depth + 1);
+    }
+
+    for (const auto& p : points) {
+        children[bounds.octantOf(p.pos)]->insert(p);
+    }
+
+    points.clear();
+    is_leaf = false;
+}
+
+void TemporalOctreeNode::insert(const TimedPoint& p) {
+    if (!bounds.contains(p.pos)) return;
+
+    count++;
+    minTime = min(minTime, p.time);
+    maxTime = max(maxTime, p.time);
+
+    if (is_leaf) {
+        if (depth >= MAX_DEPTH || points.size() < THRESHOLD) {
+            points.push_back(p);
+            return;
+        }
+        subdivide();
+    }
+
+    // Un hijo descartado por expiracion se vuelve a crear al recibir puntos
+    int octant = bounds.octantOf(p.pos);
+    if (!children[octant]) {
+        children[octant] = make_unique<TemporalOctreeNode>(bounds.octant(octant), depth + 1);
+    }
+    children[octant]->insert(p);
+}
+
+void TemporalOctreeNode::rangeQuery(const BoundingBox& range, double t0, double t1,
+                                    vector<TimedPoint>& result) const {
+    // Poda espacial y temporal
+    if (count == 0 || maxTime < t0 || minTime > t1 || !bounds.intersects(range)) {
+        return;
+    }
+
+    if (is_leaf) {
+        for (const auto& p : points) {
+            if (p.time >= t0 && p.time <= t1 && range.contains(p.pos)) {
+                result.push_back(p);
+            }
+        }
+        return;
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        if (children[i]) {
+            children[i]->rangeQuery(range, t0, t1, result);
+        }
+    }
+}
+
+void TemporalOctreeNode::collectPoints(vector<TimedPoint>& out) const {
+    if (is_leaf) {
+        out.insert(out.end(), points.begin(), points.end());
+        return;
+    }
+    for (int i = 0; i < 8; ++i) {
+        if (children[i]) children[i]->collectPoints(out);
+    }
+}
+
+// Recalcula count y el rango de tiempo a partir de los puntos o de los hijos
+void TemporalOctreeNode::refresh() {
+    count = 0;
+    minTime = numeric_limits<double>::infinity();
+    maxTime = -numeric_limits<double>::infinity();
+
+    if (is_leaf) {
+        count = points.size();
+        for (const auto& p : points) {
+            minTime = min(minTime, p.time);
+            maxTime = max(maxTime, p.time);
+        }
+        return;
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        if (!children[i]) continue;
+        count += children[i]->count;
+        minTime = min(minTime, children[i]->minTime);
+        maxTime = max(maxTime, children[i]->maxTime);
+    }
+}
+
+void TemporalOctreeNode::expireBefore(double t, ExpiryStats& stats) {
+    // Nada que expirar en este subarbol
+    if (count == 0 || minTime >= t) return;
+
+    if (is_leaf) {
+        size_t before = points.size();
+        points.erase(remove_if(points.begin(), points.end(),
+                               [t](const TimedPoint& p) { return p.time < t; }),
+                     points.end());
+        stats.removedPoints += before - points.size();
+        refresh();
+        return;
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        // Un hijo vacio tiene maxTime = -inf: se conserva para no recrearlo en el siguiente insert
+        if (!children[i] || children[i]->count == 0) continue;
+
+        if (children[i]->maxTime < t) {
+            // Todo el subarbol es viejo: se descarta completo
+            stats.droppedSubtrees++;
+            stats.droppedPoints += children[i]->count;
+            children[i].reset();
+        } else {
+            children[i]->expireBefore(t, stats);
+        }
+    }
+    refresh();
+
+    // Con pocos puntos restantes el nodo vuelve a ser hoja
+    if (count <= (size_t)THRESHOLD) {
+        vector<TimedPoint> remaining;
+        collectPoints(remaining);
+        for (int i = 0; i < 8; ++i) children[i].reset();
+        points = move(remaining);
+        is_leaf = true;
+    }
+}
+
+void TemporalOctreeNode::getStats(int& totalNodes, int& leafNodes, int& maxDepth, int& totalPoints) const {
+    collectTreeStats(this, totalNodes, leafNodes, maxDepth, totalPoints);
+}
+
+// Ventana de tiempo particionada por epocas [k * epochLength, (k + 1) * epochLength)
+class TemporalOctree {
+public:
+    TemporalOctree(const BoundingBox& world, double epochLength);
+
+    void insert(const TimedPoint& p);
+    void rangeQuery(const BoundingBox& range, double t0, double t1, vector<TimedPoint>& result) const;
+
+    // Descarta las epocas cuyo contenido es anterior a t y filtra la que cruza t
+    void expireBefore(double t, ExpiryStats& stats);
+
+    size_t size() const { return total; }
+    size_t epochCount() const { return epochs.size(); }
+    void getStats(int& totalNodes, int& leafNodes, int& maxDepth, int& totalPoints) const;
+
+private:
+    BoundingBox world;
+    double epochLength;
+    map<long long, unique_ptr<TemporalOctreeNode>> epochs;
+    size_t total;
+};
+
+TemporalOctree::TemporalOctree(const BoundingBox& w, double length)
+    : world(w), epochLength(length), total(0) {}
+
+void TemporalOctree::insert(const TimedPoint& p) {
+    if (!world.contains(p.pos)) return;
+
+    unique_ptr<TemporalOctreeNode>& tree = epochs[(long long)floor(p.time / epochLength)];
+    if (!tree) tree = make_unique<TemporalOctreeNode>(world, 0);
+    tree->insert(p);
+    total++;
+}
+
+void TemporalOctree::rangeQuery(const BoundingBox& range, double t0, double t1,
+                                vector<TimedPoint>& result) const {
+    // Cada epoca poda por su propio [minTime, maxTime]
+    for (const auto& kv : epochs) {
+        kv.second->rangeQuery(range, t0, t1, result);
+    }
+}
+
+void TemporalOctree::expireBefore(double t, ExpiryStats& stats) {
+    for (auto it = epochs.begin(); it != epochs.end(); ) {
+        TemporalOctreeNode& tree = *it->second;
+
+        if (tree.count == 0) {
+            // Quedo vacia en una expiracion anterior: no cuenta como descarte en bloque
+            it = epochs.erase(it);
+        } else if (tree.maxTime < t) {
+            stats.droppedEpochs++;
+            stats.epochPoints += tree.count;
+            total -= tree.count;
+            it = epochs.erase(it);
+        } else {
+            if (tree.minTime < t) {
+                size_t before = tree.count;
+                tree.expireBefore(t, stats);
+                total -= before - tree.count;
+            }
+            ++it;
+        }
+    }
+}
+
+void TemporalOctree::getStats(int& totalNodes, int& leafNodes, int& maxDepth, int& totalPoints) const {
+    for (const auto& kv : epochs) {
+        kv.second->getStats(totalNodes, leafNodes, maxDepth, totalPoints);
+    }
+}
+
+// =============================================================================
+// MODO ENTERO: DESCENSO POR LLAVE MORTON
+// =============================================================================
+// Cada punto se cuantiza una sola vez a una rejilla de 21 bits por eje y se
+// calcula su llave Morton (bit 2 = x, bit 1 = y, bit 0 = z en cada nivel, igual
+// que determineOctant). Las hojas guardan la llave junto a cada punto, asi al
+// subdividir no se vuelve a cuantizar. El octante en la profundidad d son 3
+// bits de la llave, sin recalcular puntos medios. Los nodos no guardan BoundingBox: los limites
+// se derivan de (profundidad, prefijo de la llave) durante el recorrido, y los
+// hijos se crean solo cuando reciben puntos.
+const int MORTON_BITS = 21;
+
+// Separa los 21 bits bajos de v dejando dos ceros entre cada bit
+uint64_t spreadBits3(uint32_t v) {
+    uint64_t x = v & 0x1FFFFF;
+    x = (x | x << 32) & 0x1F00000000FFFFULL;
+    x = (x | x << 16) & 0x1F0000FF0000FFULL;
+    x = (x | x << 8)  & 0x100F00F00F00F00FULL;
+    x = (x | x << 4)  & 0x10C30C30C30C30C3ULL;
+    x = (x | x << 2)  & 0x1249249249249249ULL;
+    return x;
+}
+
+class MortonOctree {
+public:
+    struct Node {
+        vector<Point> points;
+        vector<uint64_t> keys;        // Llave Morton de cada punto (paralelo a points)
+        unique_ptr<Node> children[8];
+        bool is_leaf = true;
+    };
+
+    explicit MortonOctree(const BoundingBox& world);
+
+    // Complejidad: O(log n) promedio, una sola cuantizacion por punto
+    void insert(const Point& p);
+
+    // Mismo resultado que OctreeNode::rangeQuery
+    void rangeQuery(const BoundingBox& range, vector<Point>& result) const;
+
+    // Hoja que contiene el punto (nullptr si esta fuera del mundo)
+    const Node* findLeaf(const Point& p, int& depth) const;
+
+    // Limites del nodo con ese prefijo de llave en esa profundidad
+    BoundingBox nodeBounds(int depth, uint64_t prefix) const;
+
+    uint64_t mortonKey(const Point& p) const;
+
+    void getStats(int& totalNodes, int& leafNodes, int& maxDepth, int& totalPoints) const;
+    size_t memoryBytes() const;
+
+private:
+    static int octantAt(uint64_t key, int depth) {
+        return (int)((key >> (3 * (MORTON_BITS - 1 - depth))) & 7);
+    }
+
+    uint32_t quantize(double v, double origin, double scale) const;
+    void subdivide(Node* node, int depth);
+    // Rango cuantizado que se comparte durante el recorrido
+    struct RangeContext {
+        uint32_t qmin[3], qmax[3];
+        const BoundingBox* range;
+        vector<Point>* result;
+    };
+
+    void rangeQuery(const Node* node, uint32_t span, uint32_t x, uint32_t y, uint32_t z,
+                    const RangeContext& ctx) const;
+    void getStats(const Node* node, int depth, int& totalNodes, int& leafNodes,
+                  int& maxDepth, int& totalPoints, size_t& bytes) const;
+
+    BoundingBox world;
+    double scaleX, scaleY, scaleZ;
+    Node root;
+};
+
+MortonOctree::MortonOctree(const BoundingBox& w) : world(w) {
+    const double cells = (double)(1u << MORTON_BITS);
+    scaleX = cells / (world.max.x - world.min.x);
+    scaleY = cells / (world.max.y - world.min.y);
+    scaleZ = cells / (world.max.z - world.min.z);
+}
+
+uint32_t MortonOctree::quantize(double v, double origin, double scale) const {
+    const uint32_t last = (1u << MORTON_BITS) - 1;
+    double cell = (v - origin) * scale;
+    if (cell <= 0.0) return 0;
+    return min(last, (uint32_t)cell);
+}
+
+uint64_t MortonOctree::mortonKey(const Point& p) const {
+    return (spreadBits3(quantize(p.x, world.min.x, scaleX)) << 2) |
+           (spreadBits3(quantize(p.y, world.min.y, scaleY)) << 1) |
+            spreadBits3(quantize(p.z, world.min.z, scaleZ));
+}
+
+BoundingBox MortonOctree::nodeBounds(int depth, uint64_t prefix) const {
+    uint32_t cx = 0, cy = 0, cz = 0;
+    for (int d = 0; d < depth; ++d) {
+        int octant = (int)((prefix >> (3 * (depth - 1 - d))) & 7);
+        cx = (cx << 1) | ((octant >> 2) & 1);
+        cy = (cy << 1) | ((octant >> 1) & 1);
+        cz = (cz << 1) | (octant & 1);
+    }
+
+    double sx = (world.max.x - world.min.x) / (1u << depth);
+    double sy = (world.max.y - world.min.y) / (1u << depth);
+    double sz = (world.max.z - world.min.z) / (1u << depth);
+    Point lo(world.min.x + cx * sx, world.min.y + cy * sy, world.min.z + cz * sz);
+    return BoundingBox(lo, Point(lo.x + sx, lo.y + sy, lo.z + sz));
+}
+
+void MortonOctree::subdivide(Node* node, int depth) {
+    for (size_t i = 0; i < node->points.size(); ++i) {
+        auto& child = node->children[octantAt(node->keys[i], depth)];
+        if (!child) child = make_unique<Node>();
+        child->points.push_back(node->points[i]);
+        child->keys.push_back(node->keys[i]);
+    }
+    node->points.clear();
+    node->points.shrink_to_fit();
+    node->keys.clear();
+    node->keys.shrink_to_fit();
+    node->is_leaf = false;
+}
+
+void MortonOctree::insert(const Point& p) {
+    if (!world.contains(p)) return;
+
+    uint64_t key = mortonKey(p);
+    Node* node = &root;
+    int depth = 0;
+
+    while (true) {
+        if (node->is_leaf) {
+            if (depth >= MAX_DEPTH || node->points.size() < THRESHOLD) {
+                node->points.push_back(p);
+                node->keys.push_back(key);
+                return;
+            }
+            subdivide(node, depth);
+        }
+
+        auto& child = node->children[octantAt(key, depth)];
+        if (!child) child = make_unique<Node>();
+        node = child.get();
+        depth++;
+    }
+}
+
+const MortonOctree::Node* MortonOctree::findLeaf(const Point& p, int& depth) const {
+    if (!world.contains(p)) return nullptr;
+
+    uint64_t key = mortonKey(p);
+    const Node* node = &root;
+    depth = 0;
+
+    while (!node->is_leaf) {
+        const Node* child = node->children[octantAt(key, depth)].get();
+        if (!child) break;
+        node = child;
+        depth++;
+    }
+    return node;
+}
+
+void MortonOctree::rangeQuery(const BoundingBox& range, vector<Point>& result) const {
+    if (!world.intersects(range)) return;
+
+    // El rango se cuantiza una vez; la poda se hace con enteros
+    RangeContext ctx = {{quantize(range.min.x, world.min.x, scaleX),
+                         quantize(range.min.y, world.min.y, scaleY),
+                         quantize(range.min.z, world.min.z, scaleZ)},
+                        {quantize(range.max.x, world.min.x, scaleX),
+                         quantize(range.max.y, world.min.y, scaleY),
+                         quantize(range.max.z, world.min.z, scaleZ)},
+                        &range, &result};
+    rangeQuery(&root, 1u << MORTON_BITS, 0, 0, 0, ctx);
+}
+
+// (x, y, z) es la esquina entera minima del nodo y span su lado en celdas
+void MortonOctree::rangeQuery(const Node* node, uint32_t span, uint32_t x, uint32_t y, uint32_t z,
+                              const RangeContext& ctx) const {
+    uint32_t lo[3] = {x, y, z};
+
+    bool inside = true;
+    for (int a = 0; a < 3; ++a) {
+        uint32_t hi = lo[a] + span - 1;
+        if (hi < ctx.qmin[a] || lo[a] > ctx.qmax[a]) return;
+        // Solo las celdas estrictamente interiores garantizan el punto dentro del rango
+        if (lo[a] <= ctx.qmin[a] || hi >= ctx.qmax[a]) inside = false;
+    }
+
+    if (node->is_leaf) {
+        if (inside) {
+            ctx.result->insert(ctx.result->end(), node->points.begin(), node->points.end());
+            return;
+        }
+        for (const auto& p : node->points) {
+            if (ctx.range->contains(p)) ctx.result->push_back(p);
+        }
+        return;
+    }
+
+    uint32_t half = span >> 1;
+    for (int i = 0; i < 8; ++i) {
+        if (node->children[i]) {
+            rangeQuery(node->children[i].get(), half,
+                       x + ((i & 4) ? half : 0), y + ((i & 2) ? half : 0), z + ((i & 1) ? half : 0), ctx);
+        }
+    }
+}
+
+void MortonOctree::getStats(const Node* node, int depth, int& totalNodes, int& leafNodes,
+                            int& maxDepth, int& totalPoints, size_t& bytes) const {
+    totalNodes++;
+    bytes += sizeof(Node) + node->points.capacity() * sizeof(Point) + node->keys.capacity() * sizeof(uint64_t);
+    if (depth > maxDepth) maxDepth = depth;
+
+    if (node->is_leaf) {
+        leafNodes++;
+        totalPoints += node->points.size();
+        return;
+    }
+    for (int i = 0; i < 8; ++i) {
+        if (node->children[i]) {
+            getStats(node->children[i].get(), depth + 1, totalNodes, leafNodes, maxDepth, totalPoints, bytes);
+        }
+    }
+}
+
+void MortonOctree::getStats(int& totalNodes, int& leafNodes, int& maxDepth, int& totalPoints) const {
+    size_t bytes = 0;
+    getStats(&root, 0, totalNodes, leafNodes, maxDepth, totalPoints, bytes);
+}
+
+size_t MortonOctree::memoryBytes() const {
+    int totalNodes = 0, leafNodes = 0, maxDepth = 0, totalPoints = 0;
+    size_t bytes = 0;
+    getStats(&root, 0, totalNodes, leafNodes, maxDepth, totalPoints, bytes);
+    return bytes;
+}
+
+// =============================================================================
+// AJUSTE AUTOMATICO DE THRESHOLD Y MAX_DEPTH
+// =============================================================================
+// Modelo de costo de una consulta por rango: cada nodo visitado (prueba de
+// interseccion) cuesta nodeCost y cada punto revisado en una hoja cuesta
+// pointCost; ambos se miden en esta maquina. Para cada candidato (capacidad de
+// hoja, profundidad maxima) se simula el arbol sobre una muestra ordenada por
+// llave Morton, escalando los conteos al tamano real, y se evalua la traza de
+// consultas registrada. Opcionalmente elige limites distintos por region.
+const int TUNER_THRESHOLDS[] = {2, 4, 8, 16, 32, 64, 128, 256};
+const int TUNER_DEPTHS[] = {4, 6, 8, 10, 12};
+
+struct RegionLimits {
+    int maxDepth;
+    int threshold;
+};
+
+struct TuningResult {
+    int threshold;                    // Mejor configuracion global
+    int maxDepth;
+    double predictedUs;               // Costo predicho de toda la traza
+    double defaultPredictedUs;        // Costo predicho con MAX_DEPTH / THRESHOLD
+
+    int regionDepth;                  // Regiones de la version adaptativa
+    vector<RegionLimits> regions;     // Limites por region en orden Z
+    double adaptivePredictedUs;
+};
+
+// Cuenta nodos visitados y puntos revisados por rangeQuery en un arbol real
+void rangeQueryCost(const OctreeNode* node, const BoundingBox& range, double& nodes, double& points) {
+    nodes += 1;
+    if (!node->bounds.intersects(range)) return;
+
+    if (node->is_leaf) {
+        points += node->points.size();
+        return;
+    }
+    for (int i = 0; i < 8; ++i) {
+        if (node->children[i]) rangeQueryCost(node->children[i].get(), range, nodes, points);
+    }
+}
+
+// Mayor cantidad de puntos en una sola hoja
+size_t largestLeaf(const OctreeNode* node) {
+    if (node->is_leaf) return node->points.size();
+
+    size_t best = 0;
+    for (int i = 0; i < 8; ++i) {
+        if (node->children[i]) best = max(best, largestLeaf(node->children[i].get()));
+    }
+    return best;
+}
+
+class OctreeTuner {
+public:
+    OctreeTuner(const BoundingBox& world, const vector<Point>& data, size_t sampleSize);
+
+    // Mide nodeCost y pointCost con dos arboles de los datos completos, para
+    // que el costo incluya los fallos de cache del tamano real
+    void calibrate(const vector<Point>& data, const vector<BoundingBox>& trace);
+
+    // Costo predicho de la traza (microsegundos) con limites globales
+    double predict(const vector<BoundingBox>& trace, int threshold, int maxDepth) const;
+
+    TuningResult tune(const vector<BoundingBox>& trace, int regionDepth) const;
+
+    // Construye el octree con los limites elegidos (globales o por region)
+    static unique_ptr<OctreeNode> build(const BoundingBox& world, const vector<Point>& data,
+                                        const TuningResult& tuning, bool adaptive);
+
+    double nodeCostNs() const { return nodeCost; }
+    double pointCostNs() const { return pointCost; }
+
+private:
+    struct Cost {
+        double nodes = 0;
+        double points = 0;
+    };
+
+    // Recorre el arbol simulado: [lo, hi) son las llaves de la muestra en el nodo
+    // y estimated los puntos reales que se estiman en el
+    void simulate(size_t lo, size_t hi, double estimated, int depth, uint64_t prefix, const BoundingBox& box,
+                  int threshold, int maxDepth, int forceDepth, const BoundingBox& range,
+                  vector<Cost>& regionCost, int regionDepth) const;
+
+    double toUs(const Cost& c) const { return (c.nodes * nodeCost + c.points * pointCost) / 1000.0; }
+
+    BoundingBox world;
+    MortonOctree grid;                // Solo se usa para calcular llaves
+    vector<Point> sample;
+    vector<uint64_t> keys;            // Llaves Morton de la muestra, ordenadas
+    double scale;                     // Puntos reales por punto de muestra
+    double nodeCost;                  // ns por nodo visitado
+    double pointCost;                 // ns por punto revisado
+};
+
+OctreeTuner::OctreeTuner(const BoundingBox& w, const vector<Point>& data, size_t sampleSize)
+    : world(w), grid(w), scale(1.0), nodeCost(20.0), pointCost(3.0) {
+    size_t step = max<size_t>(1, data.size() / max<size_t>(1, sampleSize));
+    for (size_t i = 0; i < data.size(); i += step) {
+        if (world.contains(data[i])) sample.push_back(data[i]);
+    }
+    for (const auto& p : sample) keys.push_back(grid.mortonKey(p));
+    sort(keys.begin(), keys.end());
+    if (!sample.empty()) scale = (double)data.size() / sample.size();
+}
+
+void OctreeTuner::calibrate(const vector<Point>& data, const vector<BoundingBox>& trace) {
+    // Un arbol fino (dominado por nodos) y uno grueso (dominado por puntos)
+    const int capacities[2] = {2, 256};
+    double nodes[2] = {0, 0}, points[2] = {0, 0}, ns[2] = {0, 0};
+
+    for (int c = 0; c < 2; ++c) {
+        OctreeNode root(world, 0, 12, capacities[c]);
+        for (const auto& p : data) root.insert(p);
+
+        for (const auto& range : trace) rangeQueryCost(&root, range, nodes[c], points[c]);
+
+        // Mejor de 3 repeticiones para reducir ruido
+        double best = numeric_limits<double>::infinity();
+        for (int rep = 0; rep < 3; ++rep) {
+            vector<Point> result;
+            auto start = high_resolution_clock::now();
+            for (const auto& range : trace) {
+                result.clear();
+                root.rangeQuery(range, result);
+            }
+            auto end = high_resolution_clock::now();
+            best = min(best, (double)duration_cast<nanoseconds>(end - start).count());
+        }
+        ns[c] = best;
+    }
+
+    // Resolver [nodes points] * [nodeCost pointCost]^T = ns
+    double det = nodes[0] * points[1] - nodes[1] * points[0];
+    if (abs(det) > 1e-9) {
+        double a = (ns[0] * points[1] - ns[1] * points[0]) / det;
+        double b = (nodes[0] * ns[1] - nodes[1] * ns[0]) / det;
+        if (a > 0 && b > 0) {
+            nodeCost = a;
+            pointCost = b;
+        }
+    }
+}
+
+void OctreeTuner::simulate(size_t lo, size_t hi, double estimated, int depth, uint64_t prefix,
+                           const BoundingBox& box, int threshold, int maxDepth, int forceDepth, const BoundingBox& range,
+                           vector<Cost>& regionCost, int regionDepth) const {
+    // Los nodos por encima de las regiones se acumulan en la ultima posicion
+    Cost& cost = (depth >= regionDepth)
+        ? regionCost[prefix >> (3 * (depth - regionDepth))]
+        : regionCost.back();
+
+    cost.nodes += 1;
+    if (!box.intersects(range)) return;
+
+    bool split = depth < forceDepth || (estimated > threshold && depth < maxDepth);
+    if (!split) {
+        cost.points += estimated;
+        return;
+    }
+
+    int shift = 3 * (MORTON_BITS - depth - 1);
+
+    // Con 0 o 1 puntos de muestra ya no hay resolucion: se asume distribucion uniforme
+    bool sparse = (hi - lo) <= 1;
+
+    size_t childLo = lo;
+    for (int i = 0; i < 8; ++i) {
+        uint64_t childPrefix = (prefix << 3) | (uint64_t)i;
+        uint64_t endKey = (childPrefix + 1) << shift;
+        size_t childHi = lower_bound(keys.begin() + childLo, keys.begin() + hi, endKey) - keys.begin();
+
+        double childEstimated = sparse ? estimated / 8.0 : (childHi - childLo) * scale;
+        simulate(childLo, childHi, childEstimated, depth + 1, childPrefix, box.octant(i),
+                 threshold, maxDepth, forceDepth, range, regionCost, regionDepth);
+        childLo = childHi;
+    }
+}
+
+double OctreeTuner::predict(const vector<BoundingBox>& trace, int threshold, int maxDepth) const {
+    vector<Cost> cost(1);
+    for (const auto& range : trace) {
+        simulate(0, keys.size(), keys.size() * scale, 0, 0, world, threshold, maxDepth, 0, range, cost, 0);
+    }
+    return toUs(cost[0]);
+}
+
+TuningResult OctreeTuner::tune(const vector<BoundingBox>& trace, int regionDepth) const {
+    TuningResult r;
+    r.threshold = THRESHOLD;
+    r.maxDepth = MAX_DEPTH;
+    r.defaultPredictedUs = predict(trace, THRESHOLD, MAX_DEPTH);
+    r.predictedUs = r.defaultPredictedUs;
+
+    size_t numRegions = (size_t)1 << (3 * regionDepth);
+    r.regionDepth = regionDepth;
+    r.regions.assign(numRegions, RegionLimits{MAX_DEPTH, THRESHOLD});
+    vector<double> bestRegion(numRegions, numeric_limits<double>::infinity());
+    double topUs = 0.0;
+
+    for (int threshold : TUNER_THRESHOLDS) {
+        for (int maxDepth : TUNER_DEPTHS) {
+            // Global
+            double us = predict(trace, threshold, maxDepth);
+            if (us < r.predictedUs) {
+                r.predictedUs = us;
+                r.threshold = threshold;
+                r.maxDepth = maxDepth;
+            }
+
+            // Por region: se subdivide hasta regionDepth y cada region elige sus limites
+            if (maxDepth < regionDepth) continue;
+            vector<Cost> cost(numRegions + 1);
+            for (const auto& range : trace) {
+                simulate(0, keys.size(), keys.size() * scale, 0, 0, world, threshold, maxDepth, regionDepth,
+                         range, cost, regionDepth);
+            }
+            topUs = toUs(cost.back());
+            for (size_t i = 0; i < numRegions; ++i) {
+                double regionUs = toUs(cost[i]);
+                if (regionUs < bestRegion[i]) {
+                    bestRegion[i] = regionUs;
+                    r.regions[i] = RegionLimits{maxDepth, threshold};
+                }
+            }
+        }
+    }
+
+    r.adaptivePredictedUs = topUs;
+    for (double us : bestRegion) r.adaptivePredictedUs += us;
+    return r;
+}
+
+// Reune en orden Z los nodos de una profundidad dada
+void collectNodesAtDepth(OctreeNode* node, int depth, vector<OctreeNode*>& out) {
+    if (node->depth == depth) {
+        out.push_back(node);
+        return;
+    }
+    for (int i = 0; i < 8; ++i) {
+        if (node->children[i]) collectNodesAtDepth(node->children[i].get(), depth, out);
+    }
+}
+
+unique_ptr<OctreeNode> OctreeTuner::build(const BoundingBox& world, const vector<Point>& data,
+                                          const TuningResult& tuning, bool adaptive) {
+    unique_ptr<OctreeNode> root;
+
+    if (!adaptive) {
+        root = make_unique<OctreeNode>(world, 0, tuning.maxDepth, tuning.threshold);
+    } else {
+        root = make_unique<OctreeNode>(world, 0, tuning.regionDepth, THRESHOLD);
+        root->splitTo(tuning.regionDepth);
+
+        vector<OctreeNode*> regions;
+        collectNodesAtDepth(root.get(), tuning.regionDepth, regions);
+        for (size_t i = 0; i < regions.size() && i < tuning.regions.size(); ++i) {
+            regions[i]->setLimits(tuning.regions[i].maxDepth, tuning.regions[i].threshold);
+        }
+    }
+
+    for (const auto& p : data) root->insert(p);
+    return root;
+}
+
+// =============================================================================
+// OCTREE DISTRIBUIDO EN PROCESOS (SHARDS) CON COORDINADOR
+// =============================================================================
+// El mundo se reparte por octantes de primer nivel en rangos contiguos de
+// llave Morton (octante * N / 8). Octantes contiguos en orden Z forman una
+// caja, asi que cada proceso hijo construye su OctreeNode solo sobre su region
+// y no gasta niveles en la parte del mundo que no le toca. El coordinador se comunica por sockets Unix
+// (socketpair): agrupa los inserts por shard y reparte las consultas solo a
+// los shards cuya region interseca la consulta, luego junta las respuestas.
+#ifndef _WIN32
+
+enum ShardMessage : uint32_t {
+    MSG_INSERT = 1,       // Payload: count puntos
+    MSG_RANGE = 2,        // Payload: 2 puntos (min, max). Respuesta: puntos
+    MSG_KNN = 3,          // Payload: 1 punto, count = k. Respuesta: puntos
+    MSG_SYNC = 4,         // Respuesta: count = puntos almacenados
+    MSG_SHUTDOWN = 5
+};
+
+struct MessageHeader {
+    uint32_t type;
+    uint32_t count;
+};
+
+bool sendAll(int fd, const void* data, size_t len) {
+    const char* p = static_cast<const char*>(data);
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool recvAll(int fd, void* data, size_t len) {
+    char* p = static_cast<char*>(data);
+    while (len > 0) {
+        ssize_t n = recv(fd, p, len, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+// Bucle del proceso hijo: atiende mensajes hasta MSG_SHUTDOWN o cierre del socket
+void runShardWorker(int fd, const BoundingBox& region) {
+    OctreeNode root(region, 0);
+    vector<Point> buffer;
+    size_t stored = 0;
+    MessageHeader h;
+
+    while (recvAll(fd, &h, sizeof(h))) {
+        if (h.type == MSG_INSERT) {
+            buffer.resize(h.count);
+            if (!recvAll(fd, buffer.data(), h.count * sizeof(Point))) break;
+            for (const auto& p : buffer) root.insert(p);
+            stored += h.count;
+            continue;
+        }
+
+        MessageHeader reply{h.type, 0};
+        buffer.clear();
+
+        if (h.type == MSG_RANGE) {
+            Point box[2];
+            if (!recvAll(fd, box, sizeof(box))) break;
+            root.rangeQuery(BoundingBox(box[0], box[1]), buffer);
+        } else if (h.type == MSG_KNN) {
+            Point q;
+            if (!recvAll(fd, &q, sizeof(q))) break;
+            root.kNearest(q, (int)h.count, buffer);
+        } else if (h.type == MSG_SYNC) {
+            reply.count = (uint32_t)stored;
+            if (!sendAll(fd, &reply, sizeof(reply))) break;
+            continue;
+        } else {
+            break;
+        }
+
+        reply.count = (uint32_t)buffer.size();
+        if (!sendAll(fd, &reply, sizeof(reply)) ||
+            !sendAll(fd, buffer.data(), buffer.size() * sizeof(Point))) {
+            break;
+        }
+    }
+    close(fd);
+}
+
+class ShardCoordinator {
+public:
+    // numShards debe ser 1, 2, 4 u 8; otro valor deja el coordinador sin iniciar
+    ShardCoordinator(const BoundingBox& world, int numShards);
+    ~ShardCoordinator();
+
+    // false si no se pudieron crear los shards o si fallo la comunicacion con alguno
+    bool started() const { return ok; }
+    int shardCount() const { return (int)shards.size(); }
+
+    // Los inserts se agrupan por shard y se envian en lotes.
+    // Todas las operaciones retornan false si un shard no responde
+    bool insert(const Point& p);
+    bool flush();
+
+    // Espera a que todos los shards procesen sus lotes y llena los puntos por shard
+    bool sync(vector<size_t>& sizes);
+
+    bool rangeQuery(const BoundingBox& range, vector<Point>& result);
+    bool kNearest(const Point& q, int k, vector<Point>& result);
+
+    // Shards contactados por todas las consultas hasta ahora
+    size_t totalFanOut() const { return fanOut; }
+
+private:
+    struct Shard {
+        pid_t pid;
+        int fd;
+        BoundingBox region;               // Union de los octantes de primer nivel asignados
+        vector<Point> pending;            // Inserts aun no enviados
+    };
+
+    static const size_t BATCH_SIZE = 4096;
+
+    int shardOf(const Point& p) const;
+    bool sendRequest(Shard& s, const MessageHeader& h, const void* payload, size_t len);
+    bool readPoints(Shard& s, vector<Point>& out);
+    bool flushShard(Shard& s);
+
+    BoundingBox world;
+    vector<Shard> shards;
+    size_t fanOut;
+    bool ok;
+};
+
+ShardCoordinator::ShardCoordinator(const BoundingBox& w, int numShards)
+    : world(w), fanOut(0), ok(true) {
+    if (numShards != 1 && numShards != 2 && numShards != 4 && numShards != 8) {
+        ok = false;
+        return;
+    }
+
+    // El shard i recibe los octantes [i * 8 / N, (i + 1) * 8 / N): en orden Z su
+    // union va de la esquina minima del primero a la maxima del ultimo
+    for (int i = 0; i < numShards; ++i) {
+        BoundingBox first = world.octant(i * 8 / numShards);
+        BoundingBox last = world.octant((i + 1) * 8 / numShards - 1);
+        shards.push_back(Shard{-1, -1, BoundingBox(first.min, last.max), {}});
+    }
+
+    // Evitar que el hijo herede texto pendiente en el buffer de salida
+    cout.flush();
+
+    for (size_t i = 0; i < shards.size(); ++i) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+            ok = false;
+            shards.erase(shards.begin() + i, shards.end());
+            return;
+        }
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            close(fds[0]);
+            close(fds[1]);
+            ok = false;
+            shards.erase(shards.begin() + i, shards.end());
+            return;
+        }
+
+        if (pid == 0) {
+            // Proceso hijo: cerrar los extremos del coordinador y atender mensajes
+            close(fds[0]);
+            for (size_t j = 0; j < i; ++j) close(shards[j].fd);
+            runShardWorker(fds[1], shards[i].region);
+            _exit(0);
+        }
+
+        close(fds[1]);
+        shards[i].pid = pid;
+        shards[i].fd = fds[0];
+    }
+}
+
+ShardCoordinator::~ShardCoordinator() {
+    MessageHeader h{MSG_SHUTDOWN, 0};
+    for (auto& s : shards) {
+        sendAll(s.fd, &h, sizeof(h));
+        close(s.fd);
+    }
+    for (auto& s : shards) {
+        waitpid(s.pid, nullptr, 0);
+    }
+}
+
+int ShardCoordinator::shardOf(const Point& p) const {
+    return world.octantOf(p) * (int)shards.size() / 8;
+}
+
+// Cualquier fallo de socket deja el coordinador inutilizable (ok = false)
+bool ShardCoordinator::sendRequest(Shard& s, const MessageHeader& h, const void* payload, size_t len) {
+    if (!sendAll(s.fd, &h, sizeof(h)) || (len > 0 && !sendAll(s.fd, payload, len))) {
+        ok = false;
+    }
+    return ok;
+}
+
+bool ShardCoordinator::readPoints(Shard& s, vector<Point>& out) {
+    MessageHeader reply;
+    if (!recvAll(s.fd, &reply, sizeof(reply))) {
+        ok = false;
+        return false;
+    }
+    size_t first = out.size();
+    out.resize(first + reply.count);
+    if (!recvAll(s.fd, out.data() + first, reply.count * sizeof(Point))) {
+        out.resize(first);
+        ok = false;
+    }
+    return ok;
+}
+
+bool ShardCoordinator::flushShard(Shard& s) {
+    if (s.pending.empty()) return ok;
+    MessageHeader h{MSG_INSERT, (uint32_t)s.pending.size()};
+    bool sent = sendRequest(s, h, s.pending.data(), s.pending.size() * sizeof(Point));
+    s.pending.clear();
+    return sent;
+}
+
+bool ShardCoordinator::insert(const Point& p) {
+    if (!ok) return false;
+    if (!world.contains(p)) return true;
+
+    Shard& s = shards[shardOf(p)];
+    s.pending.push_back(p);
+    if (s.pending.size() >= BATCH_SIZE) return flushShard(s);
+    return true;
+}
+
+bool ShardCoordinator::flush() {
+    if (!ok) return false;
+    for (auto& s : shards) {
+        if (!flushShard(s)) return false;
+    }
+    return true;
+}
+
+bool ShardCoordinator::sync(vector<size_t>& sizes) {
+    sizes.clear();
+    if (!flush()) return false;
+
+    MessageHeader h{MSG_SYNC, 0};
+    for (auto& s : shards) {
+        if (!sendRequest(s, h, nullptr, 0)) return false;
+    }
+
+    for (auto& s : shards) {
+        MessageHeader reply{0, 0};
+        if (!recvAll(s.fd, &reply, sizeof(reply)) || reply.type != MSG_SYNC) {
+            ok = false;
+            return false;
+        }
+        sizes.push_back(reply.count);
+    }
+    return true;
+}
+
+bool ShardCoordinator::rangeQuery(const BoundingBox& range, vector<Point>& result) {
+    if (!flush()) return false;
+
+    // Scatter: solo a los shards cuya region interseca el rango
+    vector<Shard*> targets;
+    for (auto& s : shards) {
+        if (s.region.intersects(range)) targets.push_back(&s);
+    }
+
+    MessageHeader h{MSG_RANGE, 0};
+    Point box[2] = {range.min, range.max};
+    for (Shard* s : targets) {
+        if (!sendRequest(*s, h, box, sizeof(box))) return false;
+    }
+
+    // Gather: los shards trabajan en paralelo mientras se leen las respuestas
+    for (Shard* s : targets) {
+        if (!readPoints(*s, result)) return false;
+    }
+    fanOut += targets.size();
+    return true;
+}
+
+bool ShardCoordinator::kNearest(const Point& q, int k, vector<Point>& result) {
+    if (!flush()) return false;
+    if (k <= 0) return true;
+
+    auto dist2 = [&q](const Point& p) {
+        return (p.x - q.x) * (p.x - q.x) + (p.y - q.y) * (p.y - q.y) + (p.z - q.z) * (p.z - q.z);
+    };
+
+    // Shards ordenados por distancia a su region
+    vector<pair<double, Shard*>> order;
+    for (auto& s : shards) order.push_back({s.region.distanceSquared(q), &s});
+    sort(order.begin(), order.end(),
+         [](const pair<double, Shard*>& a, const pair<double, Shard*>& b) { return a.first < b.first; });
+
+    MessageHeader h{MSG_KNN, (uint32_t)k};
+
+    // Fase 1: el shard mas cercano fija una cota para la k-esima distancia
+    vector<Point> candidates;
+    if (!sendRequest(*order[0].second, h, &q, sizeof(q)) || !readPoints(*order[0].second, candidates)) {
+        return false;
+    }
+    fanOut++;
+
+    double bound = ((int)candidates.size() == k) ? dist2(candidates.back())
+                                                 : numeric_limits<double>::infinity();
+
+    // Fase 2: scatter-gather solo a los shards que pueden mejorar la cota
+    vector<Shard*> targets;
+    for (size_t i = 1; i < order.size(); ++i) {
+        if (order[i].first <= bound) targets.push_back(order[i].second);
+    }
+    for (Shard* s : targets) {
+        if (!sendRequest(*s, h, &q, sizeof(q))) return false;
+    }
+    for (Shard* s : targets) {
+        if (!readPoints(*s, candidates)) return false;
+    }
+    fanOut += targets.size();
+
+    sort(candidates.begin(), candidates.end(),
+         [&dist2](const Point& a, const Point& b) { return dist2(a) < dist2(b); });
+    if ((int)candidates.size() > k) candidates.resize(k);
+    result.insert(result.end(), candidates.begin(), candidates.end());
+    return true;
+}
+
+#endif
+
+// =============================================================================
+// PERFILADO CON CONTADORES DE HARDWARE (perf_event_open)
+// =============================================================================
+// En Linux abre contadores de ciclos, instrucciones, fallos de LLC y fallos de
+// prediccion de saltos solo para este proceso en modo usuario. Si el kernel no
+// los permite (perf_event_paranoid, contenedores, maquinas virtuales sin PMU) o
+// en otros sistemas, cada contador queda marcado como no disponible y solo se
+// reporta el tiempo. Los contadores forman un grupo con ciclos como lider: el
+// kernel los programa juntos y se leen en una sola llamada, asi el IPC y las
+// razones por punto salen de la misma ventana de medicion.
+enum PerfCounterId {
+    PERF_CYCLES = 0,
+    PERF_INSTRUCTIONS,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_COUNTER_COUNT
+};
+
+const char* const PERF_COUNTER_NAMES[PERF_COUNTER_COUNT] = {
+    "ciclos", "instrucciones", "fallos LLC", "fallos de salto"
+};
+
+struct PerfSample {
+    double ns = 0.0;
+    bool valid[PERF_COUNTER_COUNT] = {};
+    double value[PERF_COUNTER_COUNT] = {};
+};
+
+class PerfProfiler {
+public:
+    PerfProfiler();
+    ~PerfProfiler();
+
+    bool counterAvailable(int id) const { return fds[id] >= 0; }
+    bool anyAvailable() const;
+
+    void start();
+    PerfSample stop();
+
+private:
+    int fds[PERF_COUNTER_COUNT];
+    int leader;                           // fd del lider del grupo (-1 si no hay)
+    high_resolution_clock::time_point begin;
+};
+
+#ifdef __linux__
+// groupFd = -1 abre un nuevo lider (deshabilitado); si no, el contador se une
+// al grupo y se habilita/deshabilita junto con su lider
+int openPerfCounter(uint32_t type, uint64_t config, int groupFd) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = (groupFd == -1) ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // Si el kernel multiplexa el grupo, se escala con el tiempo activo
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0);
+}
+#endif
+
+PerfProfiler::PerfProfiler() : leader(-1) {
+    for (int i = 0; i < PERF_COUNTER_COUNT; ++i) fds[i] = -1;
+
+#ifdef __linux__
+    const uint32_t types[PERF_COUNTER_COUNT] = {
+        PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE
+    };
+    const uint64_t configs[PERF_COUNTER_COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    // Ciclos es el lider; si no esta disponible, el primer contador que abra toma su lugar.
+    // stop() depende de este orden: la lectura del grupo sigue el orden de apertura
+    for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+        fds[i] = openPerfCounter(types[i], configs[i], leader);
+        if (fds[i] >= 0 && leader < 0) leader = fds[i];
+    }
+#endif
+}
+
+PerfProfiler::~PerfProfiler() {
+#ifdef __linux__
+    for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+        if (fds[i] >= 0) close(fds[i]);
+    }
+#endif
+}
+
+bool PerfProfiler::anyAvailable() const {
+    for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+        if (fds[i] >= 0) return true;
+    }
+    return false;
+}
+
+void PerfProfiler::start() {
+#ifdef __linux__
+    if (leader >= 0) {
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+    begin = high_resolution_clock::now();
+}
+
+PerfSample PerfProfiler::stop() {
+    auto end = high_resolution_clock::now();
+    PerfSample sample;
+
+#ifdef __linux__
+    if (leader >= 0) {
+        ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        // nr, tiempo habilitado, tiempo corriendo y un valor por miembro del grupo
+        uint64_t data[3 + PERF_COUNTER_COUNT];
+        ssize_t bytes = read(leader, data, sizeof(data));
+        if (bytes >= (ssize_t)(3 * sizeof(uint64_t)) && data[2] > 0 &&
+            bytes == (ssize_t)((3 + data[0]) * sizeof(uint64_t))) {
+            double scale = (double)data[1] / (double)data[2];
+            uint64_t member = 0;
+            for (int i = 0; i < PERF_COUNTER_COUNT && member < data[0]; ++i) {
+                if (fds[i] < 0) continue;
+                sample.valid[i] = true;
+                sample.value[i] = (double)data[3 + member++] * scale;
+            }
+        }
+    }
+#endif
+
+    sample.ns = (double)duration_cast<nanoseconds>(end - begin).count();
+    return sample;
+}
+
+// =============================================================================
+// FUNCIONES DE UTILIDAD Y VISUALIZACION
+// =============================================================================
+
+void printHeader(const string& title) {
+    cout << "\n" << Color::BOLD << Color::CYAN;
+    cout << "=========================================================" << endl;
+    cout << "  " << title << endl;
+    cout << "=========================================================" << Color::RESET << endl;
+}
+
+void printSubHeader(const string& title) {
+    cout << "\n" << Color::YELLOW << Color::BOLD << ">>> " << title << Color::RESET << endl;
+}
+
+void printSuccess(const string& message) {
+    cout << Color::GREEN << "[✓] " << message << Color::RESET << endl;
+}
+
+void printInfo(const string& message) {
+    cout << Color::BLUE << "[i] " << message << Color::RESET << endl;
+}
+
+void printWarning(const string& message) {
+    cout << Color::YELLOW << "[!] " << message << Color::RESET << endl;
+}
+
+void printError(const string& message) {
+    cout << Color::RED << "[✗] " << message << Color::RESET << endl;
+}
+
+// Visualizacion 2D mejorada con estadisticas
+void draw2DProjection(const OctreeNode* root, const vector<Point>& all_points) {
+    double step = 100.0 / GRID_SIZE;
+
+    printSubHeader("PROYECCION 2D (Plano XY)");
+
+    // Estadisticas del octree
+    int totalNodes = 0, leafNodes = 0, maxDepth = 0, totalPoints = 0;
+    root->getStats(totalNodes, leafNodes, maxDepth, totalPoints);
+
+    cout << Color::CYAN << "Nodos totales: " << totalNodes
+         << " | Hojas: " << leafNodes
+         << " | Profundidad max: " << maxDepth
+         << " | Puntos: " << totalPoints << Color::RESET << endl;
+
+    cout << "\n  " << Color::WHITE;
+    for(int i = 0; i < GRID_SIZE; ++i) cout << "-";
+    cout << Color::RESET << endl;
+
+    for (int j = GRID_SIZE - 1; j >= 0; --j) {
+        cout << Color::WHITE << setw(3) << (int)(j * 2.5) << "|" << Color::RESET;
+
+        for (int i = 0; i < GRID_SIZE; ++i) {
+            char marker = ' ';
+            double x_start = i * step;
+            double y_start = j * step;
+
+            int count = 0;
+            for (const auto& p : all_points) {
+                if (p.x >= x_start && p.x < (x_start + step) &&
+                    p.y >= y_start && p.y < (y_start + step)) {
+                    count++;
+                }
+            }
+
+            if (count > 0) {
+                if (count == 1) {
+                    cout << Color::GREEN << "." << Color::RESET;
+                } else if (count <= 3) {
+                    cout << Color::YELLOW << "o" << Color::RESET;
+                } else {
+                    cout << Color::RED << "@" << Color::RESET;
+                }
+            } else {
+                cout << " ";
+            }
+        }
+        cout << Color::WHITE << "|" << Color::RESET << endl;
+    }
+
+    cout << "  ";
+    for(int i = 0; i < GRID_SIZE; ++i) cout << "-";
+    cout << endl;
+
+    cout << "  ";
+    for(int i = 0; i < GRID_SIZE; ++i) {
+        if (i % 10 == 0) cout << (int)(i * 2.5);
+        else if (i % 10 == 1 && i > 1) cout << " ";
+        else cout << " ";
+    }
+    cout << endl;
+
+    cout << "\n" << Color::CYAN << "Leyenda: "
+         << Color::GREEN << "." << Color::RESET << "=1 punto  "
+         << Color::YELLOW << "o" << Color::RESET << "=2-3 puntos  "
+         << Color::RED << "@" << Color::RESET << "=4+ puntos" << endl;
+}
+
+// Valida que dos vectores contengan los mismos puntos
+bool validateResults(const vector<Point>& v1, const vector<Point>& v2) {
+    if (v1.size() != v2.size()) return false;
+
+    vector<Point> sorted1 = v1;
+    vector<Point> sorted2 = v2;
+
+    auto comparator = [](const Point& a, const Point& b) {
+        if (a.x != b.x) return a.x < b.x;
+        if (a.y != b.y) return a.y < b.y;
+        return a.z < b.z;
+    };
+
+    sort(sorted1.begin(), sorted1.end(), comparator);
+    sort(sorted2.begin(), sorted2.end(), comparator);
+
+    for (size_t i = 0; i < sorted1.size(); ++i) {
+        if (!(sorted1[i] == sorted2[i])) return false;
+    }
+
+    return true;
+}
+
+// =============================================================================
+// ESCENARIOS DE DEMOSTRACION
+// =============================================================================
+
+void scenario1_BasicDemo() {
+    printHeader("ESCENARIO 1: DEMOSTRACION BASICA");
+
+    Point min_world(0.0, 0.0, 0.0);
+    Point max_world(100.0, 100.0, 100.0);
+    BoundingBox world_bounds(min_world, max_world);
+
+    int N = 1000;
+    OctreeNode root(world_bounds, 0);
+    vector<Point> points;
+
+    printInfo("Insertando " + to_string(N) + " puntos aleatorios...");
+
+    for (int i = 0; i < N; ++i) {
+        double x = (double)rand() / RAND_MAX * 100.0;
+        double y = (double)rand() / RAND_MAX * 100.0;
+        double z = (double)rand() / RAND_MAX * 100.0;
+        Point p(x, y, z);
+        points.push_back(p);
+        root.insert(p);
+    }
+
+    printSuccess("Puntos insertados correctamente");
+    draw2DProjection(&root, points);
+}
+
+void scenario2_PerformanceBenchmark() {
+    printHeader("ESCENARIO 2: BENCHMARK DE RENDIMIENTO");
+
+    Point min_world(0.0, 0.0, 0.0);
+    Point max_world(100.0, 100.0, 100.0);
+    BoundingBox world_bounds(min_world, max_world);
+
+    vector<int> testSizes = {10000, 50000, 100000, 200000};
+
+    cout << Color::BOLD << "\nPrueba de escalabilidad con diferentes tamanos de datos:\n" << Color::RESET;
+    cout << setw(12) << "N" << setw(15) << "Octree (ms)" << setw(15) << "Naive (ms)"
+         << setw(15) << "Speedup" << setw(15) << "Puntos" << endl;
+    cout << string(70, '-') << endl;
+
+    for (int N : testSizes) {
+        OctreeNode root(world_bounds, 0);
+        vector<Point> all_points;
+
+        // Generar puntos
+        for (int i = 0; i < N; ++i) {
+            double x = (double)rand() / RAND_MAX * 100.0;
+            double y = (double)rand() / RAND_MAX * 100.0;
+            double z = (double)rand() / RAND_MAX * 100.0;
+            Point p(x, y, z);
+            all_points.push_back(p);
+            root.insert(p);
+        }
+
+        // Rango de consulta
+        Point min_range(40.0, 40.0, 40.0);
+        Point max_range(60.0, 60.0, 60.0);
+        BoundingBox query_range(min_range, max_range);
+
+        // Benchmark Octree
+        vector<Point> octree_results;
+        auto start_octree = high_resolution_clock::now();
+        root.rangeQuery(query_range, octree_results);
+        auto end_octree = high_resolution_clock::now();
+        auto time_octree = duration_cast<microseconds>(end_octree - start_octree).count();
+
+        // Benchmark Naive
+        vector<Point> naive_results;
+        auto start_naive = high_resolution_clock::now();
+        for (const auto& p : all_points) {
+            if (query_range.contains(p)) {
+                naive_results.push_back(p);
+            }
+        }
+        auto end_naive = high_resolution_clock::now();
+        auto time_naive = duration_cast<microseconds>(end_naive - start_naive).count();
+
+        double speedup = (double)time_naive / max(1.0, (double)time_octree);
+
+        cout << setw(12) << N
+             << setw(15) << fixed << setprecision(2) << time_octree / 1000.0
+             << setw(15) << time_naive / 1000.0
+             << setw(14) << setprecision(1) << speedup << "x"
+             << setw(15) << octree_results.size() << endl;
+    }
+}
+
+void scenario3_ValidationTest() {
+    printHeader("ESCENARIO 3: VALIDACION DE CORRECTITUD");
+
+    Point min_world(0.0, 0.0, 0.0);
+    Point max_world(100.0, 100.0, 100.0);
+    BoundingBox world_bounds(min_world, max_world);
+
+    int N = 50000;
+    OctreeNode root(world_bounds, 0);
+    vector<Point> all_points;
+
+    printInfo("Generando " + to_string(N) + " puntos de prueba...");
+
+    for (int i = 0; i < N; ++i) {
+        double x = (double)rand() / RAND_MAX * 100.0;
+        double y = (double)rand() / RAND_MAX * 100.0;
+        double z = (double)rand() / RAND_MAX * 100.0;
+        Point p(x, y, z);
+        all_points.push_back(p);
+        root.insert(p);
+    }
+
+    // Probar varios rangos de consulta
+    vector<pair<Point, Point>> test_ranges = {
+        {Point(40, 40, 40), Point(60, 60, 60)},
+        {Point(0, 0, 0), Point(25, 25, 25)},
+        {Point(75, 75, 75), Point(100, 100, 100)},
+        {Point(25, 25, 25), Point(75, 75, 75)},
+        {Point(45, 45, 45), Point(55, 55, 55)}
+    };
+
+    bool all_passed = true;
+
+    for (size_t i = 0; i < test_ranges.size(); ++i) {
+        BoundingBox range(test_ranges[i].first, test_ranges[i].second);
+
+        vector<Point> octree_result;
+        vector<Point> naive_result;
+
+        root.rangeQuery(range, octree_result);
+
+        for (const auto& p : all_points) {
+            if (range.contains(p)) {
+                naive_result.push_back(p);
+            }
+        }
+
+        bool passed = validateResults(octree_result, naive_result);
+
+        cout << "Prueba " << (i + 1) << " - Rango ["
+             << (int)test_ranges[i].first.x << "-" << (int)test_ranges[i].second.x << "]: ";
+
+        if (passed) {
+            printSuccess("CORRECTO (" + to_string(octree_result.size()) + " puntos)");
+        } else {
+            printError("FALLO (Octree: " + to_string(octree_result.size()) +
+                      ", Naive: " + to_string(naive_result.size()) + ")");
+            all_passed = false;
+        }
+    }
+
+    cout << "\n";
+    if (all_passed) {
+        printSuccess("TODAS LAS PRUEBAS PASARON - Implementacion correcta!");
+    } else {
+        printError("Algunas pruebas fallaron - Revisar implementacion");
+    }
+}
+
+void scenario4_EdgeCases() {
+    printHeader("ESCENARIO 4: CASOS BORDE Y EXTREMOS");
+
+    Point min_world(0.0, 0.0, 0.0);
+    Point max_world(100.0, 100.0, 100.0);
+    BoundingBox world_bounds(min_world, max_world);
+
+    // Test 1: Octree vacio
+    {
+        printSubHeader("Test 1: Consulta en Octree vacio");
+        OctreeNode root(world_bounds, 0);
+        vector<Point> result;
+        BoundingBox range(Point(40, 40, 40), Point(60, 60, 60));
+        root.rangeQuery(range, result);
+
+        if (result.empty()) {
+            printSuccess("Octree vacio retorna 0 puntos");
+        } else {
+            printError("Error: Octree vacio retorno " + to_string(result.size()) + " puntos");
+        }
+    }
+
+    // Test 2: Puntos en las esquinas
+    {
+        printSubHeader("Test 2: Puntos en esquinas del espacio");
+        OctreeNode root(world_bounds, 0);
+        vector<Point> corners = {
+            Point(0, 0, 0), Point(100, 0, 0), Point(0, 100, 0), Point(0, 0, 100),
+            Point(100, 100, 0), Point(100, 0, 100), Point(0, 100, 100), Point(100, 100, 100)
+        };
+
+        for (const auto& p : corners) {
+            root.insert(p);
+        }
+
+        printSuccess("Insertadas 8 esquinas correctamente");
+
+        // Consulta que deberia incluir todas las esquinas
+        vector<Point> result;
+        root.rangeQuery(world_bounds, result);
+
+        if (result.size() == 8) {
+            printSuccess("Consulta completa retorno todas las esquinas");
+        } else {
+            printError("Error: Se esperaban 8 puntos, se obtuvieron " + to_string(result.size()));
+        }
+    }
+
+    // Test 3: Alta densidad localizada
+    {
+        printSubHeader("Test 3: Alta densidad en region localizada");
+        OctreeNode root(world_bounds, 0);
+
+        int dense_points = 10000;
+        for (int i = 0; i < dense_points; ++i) {
+            double x = 49.0 + (double)rand() / RAND_MAX * 2.0;  // [49, 51]
+            double y = 49.0 + (double)rand() / RAND_MAX * 2.0;
+            double z = 49.0 + (double)rand() / RAND_MAX * 2.0;
+            root.insert(Point(x, y, z));
+        }
+
+        int totalNodes = 0, leafNodes = 0, maxDepth = 0, totalPoints = 0;
+        root.getStats(totalNodes, leafNodes, maxDepth, totalPoints);
+
+        cout << Color::CYAN << "  Puntos insertados: " << totalPoints << endl;
+        cout << "  Nodos creados: " << totalNodes << endl;
+        cout << "  Profundidad maxima: " << maxDepth << Color::RESET << endl;
+
+        printSuccess("Octree manejo correctamente alta densidad localizada");
+    }
+}
+
+void scenario5_Interactive() {
+    printHeader("ESCENARIO 5: MODO INTERACTIVO");
+
+    Point min_world(0.0, 0.0, 0.0);
+    Point max_world(100.0, 100.0, 100.0);
+    BoundingBox world_bounds(min_world, max_world);
+    OctreeNode root(world_bounds, 0);
+    vector<Point> all_points;
+
+    bool running = true;
+
+    while (running) {
+        cout << "\n" << Color::BOLD << Color::MAGENTA;
+        cout << "======== MENU INTERACTIVO ========" << endl;
+        cout << "1. Insertar puntos aleatorios" << endl;
+        cout << "2. Insertar punto manual" << endl;
+        cout << "3. Realizar consulta por rango" << endl;
+        cout << "4. Ver estadisticas del Octree" << endl;
+        cout << "5. Visualizar proyeccion 2D" << endl;
+        cout << "6. Limpiar Octree" << endl;
+        cout << "0. Volver al menu principal" << endl;
+        cout << "==================================" << Color::RESET << endl;
+        cout << "Opcion: ";
+
+        int opcion;
+        cin >> opcion;
+
+        if (cin.fail()) {
+            cin.clear();
+            cin.ignore(10000, '\n');
+            printError("Opcion invalida");
+            continue;
+        }
+
+        switch(opcion) {
+            case 1: {
+                int n;
+                cout << "Cantidad de puntos a insertar: ";
+                cin >> n;
+
+                if (n > 0 && n <= 1000000) {
+                    printInfo("Insertando " + to_string(n) + " puntos...");
+                    auto start = high_resolution_clock::now();
+
+                    for (int i = 0; i < n; ++i) {
+                        double x = (double)rand() / RAND_MAX * 100.0;
+                        double y = (double)rand() / RAND_MAX * 100.0;
+                        double z = (double)rand() / RAND_MAX * 100.0;
+                        Point p(x, y, z);
+                        all_points.push_back(p);
+                        root.insert(p);
+                    }
+
+                    auto end = high_resolution_clock::now();
+                    auto time_ms = duration_cast<milliseconds>(end - start).count();
+
+                    printSuccess("Puntos insertados en " + to_string(time_ms) + " ms");
+                } else {
+                    printError("Cantidad invalida");
+                }
+                break;
+            }
+
+            case 2: {
+                double x, y, z;
+                cout << "Ingrese coordenadas (x y z): ";
+                cin >> x >> y >> z;
+
+                if (x >= 0 && x <= 100 && y >= 0 && y <= 100 && z >= 0 && z <= 100) {
+                    Point p(x, y, z);
+                    all_points.push_back(p);
+                    root.insert(p);
+                    printSuccess("Punto (" + to_string(x) + ", " + to_string(y) + ", " + to_string(z) + ") insertado");
+                } else {
+                    printError("Coordenadas fuera de rango [0, 100]");
+                }
+                break;
+            }
+
+            case 3: {
+                double x1, y1, z1, x2, y2, z2;
+                cout << "Ingrese rango minimo (x y z): ";
+                cin >> x1 >> y1 >> z1;
+                cout << "Ingrese rango maximo (x y z): ";
+                cin >> x2 >> y2 >> z2;
+
+                BoundingBox range(Point(x1, y1, z1), Point(x2, y2, z2));
+                vector<Point> result;
+
+                auto start = high_resolution_clock::now();
+                root.rangeQuery(range, result);
+                auto end = high_resolution_clock::now();
+                auto time_us = duration_cast<microseconds>(end - start).count();
+
+                printSuccess("Consulta completada en " + to_string(time_us) + " microsegundos");
+                printInfo("Puntos encontrados: " + to_string(result.size()));
+
+                if (result.size() <= 10) {
+                    for (const auto& p : result) {
+                        cout << "  (" << p.x << ", " << p.y << ", " << p.z << ")" << endl;
+                    }
+                }
+                break;
+            }
+
+            case 4: {
+                int totalNodes = 0, leafNodes = 0, maxDepth = 0, totalPoints = 0;
+                root.getStats(totalNodes, leafNodes, maxDepth, totalPoints);
+
+                cout << "\n" << Color::CYAN << Color::BOLD << "ESTADISTICAS DEL OCTREE:" << Color::RESET << endl;
+                cout << Color::CYAN;
+                cout << "  Total de nodos: " << totalNodes << endl;
+                cout << "  Nodos hoja: " << leafNodes << endl;
+                cout << "  Nodos internos: " << (totalNodes - leafNodes) << endl;
+                cout << "  Profundidad maxima: " << maxDepth << endl;
+                cout << "  Puntos almacenados: " << totalPoints << endl;
+                cout << "  Factor de ramificacion promedio: "
+                     << fixed << setprecision(2)
+                     << (leafNodes > 0 ? (double)totalPoints / leafNodes : 0.0) << Color::RESET << endl;
+                break;
+            }
+
+            case 5: {
+                if (all_points.empty()) {
+                    printWarning("No hay puntos para visualizar");
+                } else {
+                    draw2DProjection(&root, all_points);
+                }
+                break;
+            }
+
+            case 6: {
+                root = OctreeNode(world_bounds, 0);
+                all_points.clear();
+                printSuccess("Octree limpiado");
+                break;
+            }
+
+            case 0: {
+                running = false;
+                break;
+            }
+
+            default:
+                printError("Opcion invalida");
+        }
+    }
+}
+
+void scenario6_StreamingCursor() {
+    printHeader("ESCENARIO 6: CURSOR DE CONSULTA PAGINADA (STREAMING)");
+
+    Point min_world(0.0, 0.0, 0.0);
+    Point max_world(100.0, 100.0, 100.0);
+    BoundingBox world_bounds(min_world, max_world);
+
+    // Rango amplio (~51% del espacio) para que el resultado sea grande
+    BoundingBox query_range(Point(10.0, 10.0, 10.0), Point(90.0, 90.0, 90.0));
+    const size_t PAGE_SIZE = 10000;
+
+    vector<int> testSizes = {200000, 1000000, 10000000};
+    bool all_passed = true;
+
+    cout << Color::BOLD << "\nrangeQuery (vector completo) vs RangeCursor (paginas de "
+         << PAGE_SIZE << " puntos):\n" << Color::RESET;
+    cout << setw(10) << "N" << setw(10) << "Puntos"
+         << setw(13) << "1ro vec(ms)" << setw(13) << "1ro cur(ms)"
+         << setw(13) << "Tot vec(ms)" << setw(13) << "Tot cur(ms)"
+         << setw(13) << "Mem vec(KB)" << setw(13) << "Mem cur(KB)" << endl;
+    cout << string(98, '-') << endl;
+
+    for (int N : testSizes) {
+        OctreeNode root(world_bounds, 0);
+
+        for (int i = 0; i < N; ++i) {
+            double x = (double)rand() / RAND_MAX * 100.0;
+            double y = (double)rand() / RAND_MAX * 100.0;
+            double z = (double)rand() / RAND_MAX * 100.0;
+            root.insert(Point(x, y, z));
+        }
+
+        // rangeQuery: el primer resultado solo esta disponible al terminar
+        vector<Point> full;
+        auto start_full = high_resolution_clock::now();
+        root.rangeQuery(query_range, full);
+        auto end_full = high_resolution_clock::now();
+        auto time_full = duration_cast<microseconds>(end_full - start_full).count();
+        size_t mem_full = full.capacity() * sizeof(Point);
+
+        // Cursor: tiempo al primer resultado y recorrido completo por paginas
+        vector<Point> page;
+        page.reserve(PAGE_SIZE);
+        size_t streamed = 0;
+
+        auto start_cursor = high_resolution_clock::now();
+        RangeCursor cursor(&root, query_range);
+        Point first;
+        if (cursor.next(first)) streamed++;
+        auto first_cursor = high_resolution_clock::now();
+        while (cursor.nextPage(page, PAGE_SIZE) > 0) {
+            streamed += page.size();
+            page.clear();
+        }
+        auto end_cursor = high_resolution_clock::now();
+
+        auto time_first = duration_cast<microseconds>(first_cursor - start_cursor).count();
+        auto time_cursor = duration_cast<microseconds>(end_cursor - start_cursor).count();
+        size_t mem_cursor = cursor.memoryBytes() + page.capacity() * sizeof(Point);
+
+        // Validacion: paginar serializando y reanudando el cursor en cada pagina
+        bool passed = (streamed == full.size());
+        string token = RangeCursor(&root, query_range).serialize();
+        size_t idx = 0;
+        while (passed) {
+            auto resumed = RangeCursor::resume(&root, token);
+            if (!resumed) {
+                passed = false;
+                break;
+            }
+            page.clear();
+            if (resumed->nextPage(page, PAGE_SIZE) == 0) break;
+            for (const auto& p : page) {
+                if (idx >= full.size() || !(p == full[idx])) passed = false;
+                idx++;
+            }
+            token = resumed->serialize();
+        }
+        passed = passed && idx == full.size();
+
+        // Terminacion temprana con limite
+        RangeCursor limited(&root, query_range, 100);
+        page.clear();
+        limited.nextPage(page, PAGE_SIZE);
+        passed = passed && page.size() == min<size_t>(100, full.size()) && limited.finished();
+
+        all_passed = all_passed && passed;
+
+        cout << setw(10) << N << setw(10) << full.size()
+             << setw(13) << fixed << setprecision(3) << time_full / 1000.0
+             << setw(13) << time_first / 1000.0
+             << setw(13) << time_full / 1000.0
+             << setw(13) << time_cursor / 1000.0
+             << setw(13) << mem_full / 1024
+             << setw(13) << mem_cursor / 1024 << endl;
+    }
+
+    // Arbol mucho mas profundo que MAX_DEPTH (depthLimit = 30): un cumulo de
+    // 1e-4 de lado y puntos repetidos llevan las hojas hasta el limite
+    {
+        printSubHeader("Paginacion en un arbol de profundidad 30");
+        OctreeNode deep(world_bounds, 0, 30, 2);
+        for (int i = 0; i < 5000; ++i) {
+            double x = 50.0 + (double)rand() / RAND_MAX * 1e-4;
+            double y = 50.0 + (double)rand() / RAND_MAX * 1e-4;
+            double z = 50.0 + (double)rand() / RAND_MAX * 1e-4;
+            deep.insert(Point(x, y, z));
+        }
+        for (int i = 0; i < 4; ++i) deep.insert(Point(50.00005, 50.00005, 50.00005));
+
+        int totalNodes = 0, leafNodes = 0, maxDepth = 0, totalPoints = 0;
+        deep.getStats(totalNodes, leafNodes, maxDepth, totalPoints);
+
+        vector<Point> full;
+        BoundingBox dense_range(Point(50.00002, 50.00002, 50.00002), Point(50.00008, 50.00008, 50.00008));
+        deep.rangeQuery(dense_range, full);
+
+        bool passed = maxDepth == 30;
+        string token = RangeCursor(&deep, dense_range).serialize();
+        vector<Point> page;
+        size_t idx = 0;
+        while (passed) {
+            auto resumed = RangeCursor::resume(&deep, token);
+            if (!resumed) {
+                passed = false;
+                break;
+            }
+            page.clear();
+            if (resumed->nextPage(page, 100) == 0) break;
+            for (const auto& p : page) {
+                if (idx >= full.size() || !(p == full[idx])) passed = false;
+                idx++;
+            }
+            token = resumed->serialize();
+        }
+        passed = passed && idx == full.size();
+
+        if (passed) {
+            printSuccess("Profundidad " + to_string(maxDepth) + ": " + to_string(full.size()) +
+                         " puntos paginados con serialize/resume");
+        } else {
+            printError("No se pudo reanudar el cursor en el arbol profundo");
+        }
+        all_passed = all_passed && passed;
+    }
+
+    cout << "\n";
+    if (all_passed) {
+        printSuccess("Cursor paginado (serialize/resume) y limite coinciden con rangeQuery en orden Z");
+    } else {
+        printError("El cursor no coincide con rangeQuery - Revisar implementacion");
+    }
+}
+
+void scenario7_QueryCache() {
+    printHeader("ESCENARIO 7: CACHE DE CONSULTAS CON INVALIDACION POR INSERT");
+
+    Point min_world(0.0, 0.0, 0.0);
+    Point max_world(100.0, 100.0, 100.0);
+    BoundingBox world_bounds(min_world, max_world);
+
+    const int N = 200000;
+    const int PANELS = 24;          // Cajas base del "dashboard"
+    const int OPERATIONS = 20000;
+    const double QUANTUM = 2.0;
+
+    // Traza: paneles con popularidad sesgada, cajas desplazadas +-0.5 en cada
+    // refresco, ~30% consultas de conteo y ~2% inserciones intercaladas
+    struct TraceOp {
+        bool isInsert;
+        bool isCount;
+        Point a, b;
+    };
+
+    vector<Point> panelCenter;
+    vector<double> panelHalf;
+    for (int i = 0; i < PANELS; ++i) {
+        panelCenter.push_back(Point(10.0 + (double)rand() / RAND_MAX * 80.0,
+                                    10.0 + (double)rand() / RAND_MAX * 80.0,
+                                    10.0 + (double)rand() / RAND_MAX * 80.0));
+        panelHalf.push_back(3.0 + (double)rand() / RAND_MAX * 7.0);
+    }
+
+    vector<TraceOp> trace;
+    int queries = 0, inserts = 0;
+    for (int i = 0; i < OPERATIONS; ++i) {
+        TraceOp op;
+        double r = (double)rand() / RAND_MAX;
+        if (r < 0.02) {
+            op.isInsert = true;
+            op.isCount = false;
+            op.a = Point((double)rand() / RAND_MAX * 100.0,
+                         (double)rand() / RAND_MAX * 100.0,
+                         (double)rand() / RAND_MAX * 100.0);
+            inserts++;
+        } else {
+            double u = (double)rand() / RAND_MAX;
+            int panel = min(PANELS - 1, (int)(u * u * PANELS));
+            const Point& c = panelCenter[panel];
+            double h = panelHalf[panel];
+            double dx = (double)rand() / RAND_MAX - 0.5;
+            double dy = (double)rand() / RAND_MAX - 0.5;
+            double dz = (double)rand() / RAND_MAX - 0.5;
+            op.isInsert = false;
+            op.isCount = ((double)rand() / RAND_MAX < 0.3);
+            op.a = Point(c.x - h + dx, c.y - h + dy, c.z - h + dz);
+            op.b = Point(c.x + h + dx, c.y + h + dy, c.z + h + dz);
+            queries++;
+        }
+        trace.push_back(op);
+    }
+
+    vector<Point> base_points;
+    for (int i = 0; i < N; ++i) {
+        base_points.push_back(Point((double)rand() / RAND_MAX * 100.0,
+                                    (double)rand() / RAND_MAX * 100.0,
+                                    (double)rand() / RAND_MAX * 100.0));
+    }
+
+    printInfo("N = " + to_string(N) + ", " + to_string(queries) + " consultas y " +
+              to_string(inserts) + " inserciones sobre " + to_string(PANELS) + " paneles");
+
+    vector<size_t> memoryCaps = {64 * 1024 * 1024, 1024 * 1024, 128 * 1024};
+    bool all_passed = true;
+
+    cout << Color::BOLD << "\nTraza repetida con rejilla de " << QUANTUM << " unidades:\n" << Color::RESET;
+    cout << setw(12) << "Limite(KB)" << setw(15) << "Sin cache(ms)" << setw(15) << "Con cache(ms)"
+         << setw(10) << "Speedup" << setw(10) << "Hit rate" << setw(12) << "Invalid."
+         << setw(10) << "Evict." << setw(10) << "Mem(KB)" << endl;
+    cout << string(94, '-') << endl;
+
+    for (size_t cap : memoryCaps) {
+        OctreeNode plain(world_bounds, 0);
+        OctreeNode cachedRoot(world_bounds, 0);
+        for (const auto& p : base_points) {
+            plain.insert(p);
+            cachedRoot.insert(p);
+        }
+        QueryCache cache(&cachedRoot, QUANTUM, cap);
+
+        long long time_plain = 0, time_cache = 0;
+        int checked = 0;
+
+        for (const auto& op : trace) {
+            if (op.isInsert) {
+                plain.insert(op.a);
+                cache.insert(op.a);
+                continue;
+            }
+
+            BoundingBox range(op.a, op.b);
+            vector<Point> plain_result, cache_result;
+            size_t plain_count = 0, cache_count = 0;
+
+            auto start_plain = high_resolution_clock::now();
+            plain.rangeQuery(range, plain_result);
+            plain_count = plain_result.size();
+            auto end_plain = high_resolution_clock::now();
+
+            auto start_cache = high_resolution_clock::now();
+            if (op.isCount) {
+                cache_count = cache.countQuery(range);
+            } else {
+                cache.rangeQuery(range, cache_result);
+                cache_count = cache_result.size();
+            }
+            auto end_cache = high_resolution_clock::now();
+
+            time_plain += duration_cast<microseconds>(end_plain - start_plain).count();
+            time_cache += duration_cast<microseconds>(end_cache - start_cache).count();
+
+            if (plain_count != cache_count) all_passed = false;
+            if (!op.isCount && ++checked % 100 == 0 && !validateResults(plain_result, cache_result)) {
+                all_passed = false;
+            }
+        }
+
+        const CacheStats& st = cache.stats();
+        double speedup = (double)time_plain / max(1.0, (double)time_cache);
+
+        cout << setw(12) << cap / 1024
+             << setw(15) << fixed << setprecision(2) << time_plain / 1000.0
+             << setw(15) << time_cache / 1000.0
+             << setw(9) << setprecision(1) << speedup << "x"
+             << setw(9) << st.hitRate() * 100.0 << "%"
+             << setw(12) << st.invalidated
+             << setw(10) << st.evicted
+             << setw(10) << cache.memoryBytes() / 1024 << endl;
+    }
+
+    // Quantum decimal (0.1) con puntos y bordes de consulta sobre la misma rejilla:
+    // los puntos en el borde deben seguir dentro aunque k * 0.1 no sea exacto
+    {
+        printSubHeader("Rejilla decimal (quantum 0.1) con puntos en los bordes");
+        OctreeNode plain(world_bounds, 0);
+        OctreeNode cachedRoot(world_bounds, 0);
+        for (int i = 0; i < 60; ++i) {
+            for (int j = 0; j < 60; ++j) {
+                for (int k = 0; k < 60; ++k) {
+                    Point p(i / 10.0, j / 10.0, k / 10.0);
+                    plain.insert(p);
+                    cachedRoot.insert(p);
+                }
+            }
+        }
+        QueryCache cache(&cachedRoot, 0.1, 64 * 1024 * 1024);
+
+        const int EDGE_QUERIES = 2000;
+        int mismatches = 0;
+        for (int q = 0; q < EDGE_QUERIES; ++q) {
+            int lo[3], len[3];
+            for (int a = 0; a < 3; ++a) {
+                lo[a] = rand() % 50;
+                len[a] = 1 + rand() % 10;
+            }
+            BoundingBox range(Point(lo[0] / 10.0, lo[1] / 10.0, lo[2] / 10.0),
+                              Point((lo[0] + len[0]) / 10.0, (lo[1] + len[1]) / 10.0,
+                                    (lo[2] + len[2]) / 10.0));
+
+            vector<Point> expected, result;
+            plain.rangeQuery(range, expected);
+            cache.rangeQuery(range, result);
+            if (!validateResults(expected, result) || cache.countQuery(range) != expected.size()) {
+                mismatches++;
+            }
+        }
+
+        cout << Color::CYAN << "  " << EDGE_QUERIES << " consultas con bordes decimales, diferencias: "
+             << mismatches << Color::RESET << endl;
+        all_passed = all_passed && mismatches == 0;
+    }
+
+    cout << "\n";
+    if (all_passed) {
+        printSuccess("El cache devuelve los mismos resultados y conteos que rangeQuery");
+    } else {
+        printError("El cache no coincide con rangeQuery - Revisar invalidacion");
+    }
+}
+
+// Compara dos listas de voxeles (orden independiente)
+bool validateVoxels(const vector<VoxelStats>& a, const vector<VoxelStats>& b) {
+    if (a.size() != b.size()) return false;
+
+    unordered_map<uint64_t, const VoxelStats*> byKey;
+    for (const auto& v : b) byKey[packVoxelKey(v.ix, v.iy, v.iz)] = &v;
+
+    for (const auto& v : a) {
+        auto it = byKey.find(packVoxelKey(v.ix, v.iy, v.iz));
+        if (it == byKey.end()) return false;
+
+        const VoxelStats& o = *it->second;
+        if (v.count != o.count || !(v.centroid == o.centroid)) return false;
+        for (int i = 0; i < 6; ++i) {
+            if (abs(v.cov[i] - o.cov[i]) > 1e-6) return false;
+        }
+    }
+    return true;
+}
+
+void scenario8_VoxelDownsample() {
+    printHeader("ESCENARIO 8: SUBMUESTREO POR VOXELES Y ESTADISTICAS POR CELDA");
+
+    Point min_world(0.0, 0.0, 0.0);
+    Point max_world(100.0, 100.0, 100.0);
+    BoundingBox world_bounds(min_world, max_world);
+
+    const double VOXEL_SIZE = 3.0;
+    int threads = max(1, (int)thread::hardware_concurrency());
+    VoxelGridSpec grid = makeVoxelGrid(world_bounds, VOXEL_SIZE);
+
+    printInfo("Voxel de " + to_string(grid.cell) + " -> " + to_string(grid.cellsX) + " celdas por eje, hilos: " +
+              to_string(threads));
+
+    vector<int> testSizes = {1000000, 10000000};
+    bool all_passed = true;
+
+    cout << Color::BOLD << "\nunordered_map vs octree (conteo, centroide, covarianza y normal por voxel):\n"
+         << Color::RESET;
+    cout << setw(12) << "N" << setw(10) << "Voxeles" << setw(12) << "Hash(ms)"
+         << setw(14) << "Oct 1h(ms)" << setw(14) << "Oct " + to_string(threads) + "h(ms)"
+         << setw(12) << "Speedup" << endl;
+    cout << string(74, '-') << endl;
+
+    for (int N : testSizes) {
+        OctreeNode root(world_bounds, 0);
+        vector<Point> all_points;
+        all_points.reserve(N);
+
+        for (int i = 0; i < N; ++i) {
+            double x = (double)rand() / RAND_MAX * 100.0;
+            double y = (double)rand() / RAND_MAX * 100.0;
+            double z = (double)rand() / RAND_MAX * 100.0;
+            Point p(x, y, z);
+            all_points.push_back(p);
+            root.insert(p);
+        }
+
+        auto start_hash = high_resolution_clock::now();
+        vector<VoxelStats> hash_voxels = voxelStatisticsHashGrid(all_points, world_bounds, VOXEL_SIZE);
+        auto end_hash = high_resolution_clock::now();
+
+        auto start_single = high_resolution_clock::now();
+        vector<VoxelStats> single_voxels = voxelStatistics(root, VOXEL_SIZE, 1);
+        auto end_single = high_resolution_clock::now();
+
+        auto start_parallel = high_resolution_clock::now();
+        vector<VoxelStats> parallel_voxels = voxelStatistics(root, VOXEL_SIZE, threads);
+        auto end_parallel = high_resolution_clock::now();
+
+        auto time_hash = duration_cast<microseconds>(end_hash - start_hash).count();
+        auto time_single = duration_cast<microseconds>(end_single - start_single).count();
+        auto time_parallel = duration_cast<microseconds>(end_parallel - start_parallel).count();
+        double speedup = (double)time_hash / max(1.0, (double)time_parallel);
+
+        all_passed = all_passed && validateVoxels(single_voxels, hash_voxels) &&
+                     validateVoxels(parallel_voxels, hash_voxels);
+
+        // La rejilla es de lado exacto VOXEL_SIZE: cada centroide cae dentro de su celda
+        for (const auto& v : parallel_voxels) {
+            all_passed = all_passed &&
+                         v.centroid.x >= v.ix * VOXEL_SIZE && v.centroid.x <= (v.ix + 1) * VOXEL_SIZE &&
+                         v.centroid.y >= v.iy * VOXEL_SIZE && v.centroid.y <= (v.iy + 1) * VOXEL_SIZE &&
+                         v.centroid.z >= v.iz * VOXEL_SIZE && v.centroid.z <= (v.iz + 1) * VOXEL_SIZE;
+        }
+
+        cout << setw(12) << N << setw(10) << parallel_voxels.size()
+             << setw(12) << fixed << setprecision(2) << time_hash / 1000.0
+             << setw(14) << time_single / 1000.0
+             << setw(14) << time_parallel / 1000.0
+             << setw(11) << setprecision(1) << speedup << "x" << endl;
+    }
+
+    // Plano z = 50 con ruido: las normales deben apuntar en z
+    {
+        printSubHeader("Normales sobre un plano con ruido");
+        OctreeNode plane(world_bounds, 0);
+        for (int i = 0; i < 200000; ++i) {
+            double x = (double)rand() / RAND_MAX * 100.0;
+            double y = (double)rand() / RAND_MAX * 100.0;
+            double z = 50.0 + ((double)rand() / RAND_MAX - 0.5) * 0.1;
+            plane.insert(Point(x, y, z));
+        }
+
+        vector<VoxelStats> voxels = voxelStatistics(plane, VOXEL_SIZE, threads);
+        int aligned = 0, measured = 0;
+        for (const auto& v : voxels) {
+            if (v.count < 3) continue;
+            measured++;
+            if (abs(v.normal.z) > 0.99) aligned++;
+        }
+
+        auto downsampled = voxelDownsampleTree(plane, VOXEL_SIZE, threads);
+        int totalNodes = 0, leafNodes = 0, maxDepth = 0, totalPoints = 0;
+        downsampled->getStats(totalNodes, leafNodes, maxDepth, totalPoints);
+
+        cout << Color::CYAN << "  Voxeles con normal: " << measured << ", alineadas con z: " << aligned << endl;
+        cout << "  Octree submuestreado: " << totalPoints << " puntos, " << totalNodes << " nodos" << Color::RESET << endl;
+        all_passed = all_passed && measured > 0 && aligned == measured &&
+                     totalPoints == (int)voxels.size();
+    }
+
+    // El mismo plano trasladado a 1e6: la covarianza es invariante a traslaciones,
+    // asi que debe coincidir con la del plano en el origen voxel por voxel
+    {
+        printSubHeader("Covarianza con coordenadas grandes (desplazamiento 1e6)");
+        const double OFFSET = 1e6;
+        BoundingBox far_bounds(Point(OFFSET, OFFSET, OFFSET),
+                               Point(OFFSET + 100.0, OFFSET + 100.0, OFFSET + 100.0));
+        OctreeNode near_plane(world_bounds, 0);
+        OctreeNode far_plane(far_bounds, 0);
+        for (int i = 0; i < 200000; ++i) {
+            double x = (double)rand() / RAND_MAX * 100.0;
+            double y = (double)rand() / RAND_MAX * 100.0;
+            double z = 50.0 + ((double)rand() / RAND_MAX - 0.5) * 0.1;
+            near_plane.insert(Point(x, y, z));
+            far_plane.insert(Point(OFFSET + x, OFFSET + y, OFFSET + z));
+        }
+
+        vector<VoxelStats> near_voxels = voxelStatistics(near_plane, VOXEL_SIZE, threads);
+        vector<VoxelStats> far_voxels = voxelStatistics(far_plane, VOXEL_SIZE, threads);
+        unordered_map<uint64_t, const VoxelStats*> byKey;
+        for (const auto& v : near_voxels) byKey[packVoxelKey(v.ix, v.iy, v.iz)] = &v;
+
+        double max_error = 0.0;
+        int aligned = 0, measured = 0;
+        bool same_cells = far_voxels.size() == near_voxels.size();
+        for (const auto& v : far_voxels) {
+            auto it = byKey.find(packVoxelKey(v.ix, v.iy, v.iz));
+            if (it == byKey.end() || it->second->count != v.count) {
+                same_cells = false;
+                continue;
+            }
+            for (int k = 0; k < 6; ++k) max_error = max(max_error, abs(v.cov[k] - it->second->cov[k]));
+            if (v.count < 3) continue;
+            measured++;
+            if (abs(v.normal.z) > 0.99) aligned++;
+        }
+
+        cout << Color::CYAN << "  Error maximo de covarianza: " << scientific << setprecision(2) << max_error
+             << fixed << setprecision(3) << ", normales alineadas con z: " << aligned << "/" << measured
+             << Color::RESET << endl;
+        all_passed = all_passed && same_cells && max_error < 1e-8 && measured > 0 && aligned == measured;
+    }
+
+    cout << "\n";
+    if (all_passed) {
+        printSuccess("Voxeles del octree coinciden con la rejilla hash y las normales son correctas");
+    } else {
+        printError("Los voxeles del octree no coinciden con la referencia - Revisar implementacion");
+    }
+}
+
+void scenario9_SlidingWindow() {
+    printHeader("ESCENARIO 9: VENTANA DE TIEMPO DESLIZANTE CON EXPIRACION EN BLOQUE");
+
+    Point min_world(0.0, 0.0, 0.0);
+    Point max_world(100.0, 100.0, 100.0);
+    BoundingBox world_bounds(min_world, max_world);
+
+    const double WINDOW = 1.0;            // Segundos de validez de cada punto
+    const double STEP = 0.0625;           // 1/16 s por lote: los limites de epoca son exactos en binario
+    const int RATE = 200000;              // Puntos por segundo simulado
+    const int STEPS = 100;
+    const int WARMUP = 20;                // Pasos hasta llenar la ventana
+    const int BATCH = (int)(RATE * STEP);
+
+    const double EPOCH = STEP;            // Una epoca por lote: cada expiracion descarta la mas vieja
+
+    BoundingBox query_range(Point(30.0, 30.0, 30.0), Point(70.0, 70.0, 70.0));
+    const double QUERY_SPAN = 0.25;       // Consulta sobre los ultimos 0.25 s
+
+    printInfo("Ventana de " + to_string(WINDOW) + " s, " + to_string(RATE) + " puntos/s, lotes de " +
+              to_string(BATCH) + " puntos");
+
+    TemporalOctree incremental(world_bounds, EPOCH);
+    deque<TimedPoint> window;
+    ExpiryStats expiry;
+
+    long long time_insert = 0, time_expire = 0, time_query_inc = 0;
+    long long time_rebuild = 0, time_query_reb = 0;
+    size_t steady_points = 0;
+    bool all_passed = true;
+    double now = 0.0;
+
+    for (int step = 0; step < STEPS; ++step) {
+        vector<TimedPoint> batch;
+        batch.reserve(BATCH);
+        for (int i = 0; i < BATCH; ++i) {
+            double x = (double)rand() / RAND_MAX * 100.0;
+            double y = (double)rand() / RAND_MAX * 100.0;
+            double z = (double)rand() / RAND_MAX * 100.0;
+            batch.push_back(TimedPoint(Point(x, y, z), now + STEP * i / BATCH));
+        }
+        now += STEP;
+        double cutoff = now - WINDOW;
+        bool measure = step >= WARMUP;
+
+        // Incremental: insertar el lote y expirar lo viejo
+        auto start_insert = high_resolution_clock::now();
+        for (const auto& p : batch) incremental.insert(p);
+        auto end_insert = high_resolution_clock::now();
+
+        auto start_expire = high_resolution_clock::now();
+        incremental.expireBefore(cutoff, expiry);
+        auto end_expire = high_resolution_clock::now();
+
+        vector<TimedPoint> inc_result;
+        auto start_q1 = high_resolution_clock::now();
+        incremental.rangeQuery(query_range, now - QUERY_SPAN, now, inc_result);
+        auto end_q1 = high_resolution_clock::now();
+
+        // Referencia: reconstruir el octree con la ventana completa en cada lote
+        for (const auto& p : batch) window.push_back(p);
+        while (!window.empty() && window.front().time < cutoff) window.pop_front();
+
+        auto start_rebuild = high_resolution_clock::now();
+        TemporalOctreeNode rebuilt(world_bounds, 0);
+        for (const auto& p : window) rebuilt.insert(p);
+        auto end_rebuild = high_resolution_clock::now();
+
+        vector<TimedPoint> reb_result;
+        auto start_q2 = high_resolution_clock::now();
+        rebuilt.rangeQuery(query_range, now - QUERY_SPAN, now, reb_result);
+        auto end_q2 = high_resolution_clock::now();
+
+        if (incremental.size() != window.size() || inc_result.size() != reb_result.size()) {
+            all_passed = false;
+        }
+        if (step % 10 == 0) {
+            vector<Point> a, b;
+            for (const auto& p : inc_result) a.push_back(p.pos);
+            for (const auto& p : window) {
+                if (p.time >= now - QUERY_SPAN && p.time <= now && query_range.contains(p.pos)) {
+                    b.push_back(p.pos);
+                }
+            }
+            all_passed = all_passed && validateResults(a, b);
+        }
+
+        if (measure) {
+            steady_points += BATCH;
+            time_insert += duration_cast<microseconds>(end_insert - start_insert).count();
+            time_expire += duration_cast<microseconds>(end_expire - start_expire).count();
+            time_query_inc += duration_cast<microseconds>(end_q1 - start_q1).count();
+            time_rebuild += duration_cast<microseconds>(end_rebuild - start_rebuild).count();
+            time_query_reb += duration_cast<microseconds>(end_q2 - start_q2).count();
+        }
+    }
+
+    int measured = STEPS - WARMUP;
+    long long total_inc = time_insert + time_expire + time_query_inc;
+    long long total_reb = time_rebuild + time_query_reb;
+
+    cout << Color::BOLD << "\nRegimen estable (" << measured << " lotes, ~"
+         << window.size() << " puntos vivos):\n" << Color::RESET;
+    cout << setw(22) << "Estrategia" << setw(14) << "Ingesta(ms)" << setw(14) << "Expirar(ms)"
+         << setw(14) << "Consulta(ms)" << setw(14) << "Lote(ms)" << setw(16) << "Puntos/s" << endl;
+    cout << string(94, '-') << endl;
+
+    cout << setw(22) << "Incremental + expirar"
+         << setw(14) << fixed << setprecision(3) << time_insert / 1000.0 / measured
+         << setw(14) << time_expire / 1000.0 / measured
+         << setw(14) << time_query_inc / 1000.0 / measured
+         << setw(14) << total_inc / 1000.0 / measured
+         << setw(16) << setprecision(0) << steady_points / max(1e-6, total_inc / 1e6) << endl;
+    cout << setw(22) << "Reconstruir ventana"
+         << setw(14) << setprecision(3) << time_rebuild / 1000.0 / measured
+         << setw(14) << 0.0
+         << setw(14) << time_query_reb / 1000.0 / measured
+         << setw(14) << total_reb / 1000.0 / measured
+         << setw(16) << setprecision(0) << steady_points / max(1e-6, total_reb / 1e6) << endl;
+
+    int totalNodes = 0, leafNodes = 0, maxDepth = 0, totalPoints = 0;
+    incremental.getStats(totalNodes, leafNodes, maxDepth, totalPoints);
+
+    cout << "\n" << Color::CYAN;
+    cout << "  Epocas de " << setprecision(4) << EPOCH << " s vivas: " << incremental.epochCount() << endl;
+    cout << "  Epocas descartadas completas: " << expiry.droppedEpochs << " (" << expiry.epochPoints
+         << " puntos, " << setprecision(1) << (double)expiry.epochPoints / max<size_t>(1, expiry.droppedEpochs)
+         << " por epoca)" << endl;
+    cout << "  Subarboles descartados en la epoca de borde: " << expiry.droppedSubtrees << " ("
+         << expiry.droppedPoints << " puntos)" << endl;
+    cout << "  Puntos expirados uno a uno: " << expiry.removedPoints << endl;
+    cout << "  Nodos del octree incremental: " << totalNodes << Color::RESET << endl;
+    cout << setprecision(3);
+
+    cout << "\n";
+    if (all_passed) {
+        printSuccess("Consultas con intervalo de tiempo coinciden con la ventana reconstruida");
+    } else {
+        printError("El octree temporal no coincide con la referencia - Revisar expiracion");
+    }
+}
+
+void scenario10_ShardedOctree() {
+    printHeader("ESCENARIO 10: OCTREE DISTRIBUIDO EN PROCESOS (SCATTER-GATHER)");
+
+#ifdef _WIN32
+    printWarning("Este escenario usa fork() y sockets Unix: solo disponible en Linux/Mac");
+#else
+    Point min_world(0.0, 0.0, 0.0);
+    Point max_world(100.0, 100.0, 100.0);
+    BoundingBox world_bounds(min_world, max_world);
+
+    const int N = 1000000;
+    const int QUERIES = 2000;
+    const int K = 10;
+
+    vector<Point> all_points;
+    all_points.reserve(N);
+    OctreeNode reference(world_bounds, 0);
+    for (int i = 0; i < N; ++i) {
+        double x = (double)rand() / RAND_MAX * 100.0;
         double y = (double)rand() / RAND_MAX * 100.0;
         double z = (double)rand() / RAND_MAX * 100.0;
         Point p(x, y, z);
         all_points.push_back(p);
-        root.insert(p);
+        reference.insert(p);
     }
 
-    // Probar varios rangos de consulta
-    vector<pair<Point, Point>> test_ranges = {
-        {Point(40, 40, 40), Point(60, 60, 60)},
-        {Point(0, 0, 0), Point(25, 25, 25)},
-        {Point(75, 75, 75), Point(100, 100, 100)},
-        {Point(25, 25, 25), Point(75, 75, 75)},
-        {Point(45, 45, 45), Point(55, 55, 55)}
+    // Cajas de lado 10 y puntos kNN aleatorios, iguales para todas las corridas
+    vector<BoundingBox> ranges;
+    vector<Point> knn_points;
+    for (int i = 0; i < QUERIES; ++i) {
+        double x = (double)rand() / RAND_MAX * 90.0;
+        double y = (double)rand() / RAND_MAX * 90.0;
+        double z = (double)rand() / RAND_MAX * 90.0;
+        ranges.push_back(BoundingBox(Point(x, y, z), Point(x + 10.0, y + 10.0, z + 10.0)));
+        knn_points.push_back(Point((double)rand() / RAND_MAX * 100.0,
+                                   (double)rand() / RAND_MAX * 100.0,
+                                   (double)rand() / RAND_MAX * 100.0));
+    }
+
+    auto dist2 = [](const Point& a, const Point& b) {
+        return (a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z);
     };
 
+    printInfo("N = " + to_string(N) + ", " + to_string(QUERIES) + " consultas por rango y " +
+              to_string(QUERIES) + " kNN (k = " + to_string(K) + "), hilos de hardware: " +
+              to_string(thread::hardware_concurrency()));
+
+    cout << Color::BOLD << "\nEscalamiento de 1 a 8 shards (procesos locales):\n" << Color::RESET;
+    cout << setw(8) << "Shards" << setw(16) << "Insert(pts/s)" << setw(16) << "Rango(q/s)"
+         << setw(16) << "kNN(q/s)" << setw(14) << "Fan-out" << setw(16) << "Max shard" << endl;
+    cout << string(86, '-') << endl;
+
+    bool all_passed = true;
+
+    for (int numShards : {1, 2, 4, 8}) {
+        ShardCoordinator coordinator(world_bounds, numShards);
+        if (!coordinator.started()) {
+            printError("No se pudieron crear los procesos de los shards");
+            return;
+        }
+
+        auto start_insert = high_resolution_clock::now();
+        bool sent = true;
+        for (const auto& p : all_points) sent = sent && coordinator.insert(p);
+        vector<size_t> sizes;
+        if (!sent || !coordinator.sync(sizes)) {
+            printError("Fallo la comunicacion con los shards durante la insercion");
+            return;
+        }
+        auto end_insert = high_resolution_clock::now();
+
+        size_t stored = 0, largest = 0;
+        for (size_t sz : sizes) {
+            stored += sz;
+            largest = max(largest, sz);
+        }
+        all_passed = all_passed && stored == all_points.size();
+
+        // Cada 100 consultas se guarda el resultado; se valida fuera de la medicion
+        vector<vector<Point>> range_samples, knn_samples;
+
+        auto start_range = high_resolution_clock::now();
+        for (int i = 0; i < QUERIES; ++i) {
+            vector<Point> result;
+            if (!coordinator.rangeQuery(ranges[i], result)) {
+                printError("Fallo la comunicacion con los shards en la consulta por rango");
+                return;
+            }
+            if (i % 100 == 0) range_samples.push_back(move(result));
+        }
+        auto end_range = high_resolution_clock::now();
+        size_t range_fan_out = coordinator.totalFanOut();
+
+        auto start_knn = high_resolution_clock::now();
+        for (int i = 0; i < QUERIES; ++i) {
+            vector<Point> result;
+            if (!coordinator.kNearest(knn_points[i], K, result)) {
+                printError("Fallo la comunicacion con los shards en la consulta kNN");
+                return;
+            }
+            if (i % 100 == 0) knn_samples.push_back(move(result));
+        }
+        auto end_knn = high_resolution_clock::now();
+        size_t knn_fan_out = coordinator.totalFanOut() - range_fan_out;
+
+        for (size_t s = 0; s < range_samples.size(); ++s) {
+            vector<Point> expected;
+            reference.rangeQuery(ranges[s * 100], expected);
+            all_passed = all_passed && validateResults(range_samples[s], expected);
+        }
+        for (size_t s = 0; s < knn_samples.size(); ++s) {
+            const Point& q = knn_points[s * 100];
+            vector<Point> expected;
+            reference.kNearest(q, K, expected);
+            bool same = knn_samples[s].size() == expected.size();
+            for (size_t j = 0; same && j < expected.size(); ++j) {
+                same = abs(dist2(knn_samples[s][j], q) - dist2(expected[j], q)) < 1e-9;
+            }
+            all_passed = all_passed && same;
+        }
+
+        double t_insert = duration_cast<microseconds>(end_insert - start_insert).count() / 1e6;
+        double t_range = duration_cast<microseconds>(end_range - start_range).count() / 1e6;
+        double t_knn = duration_cast<microseconds>(end_knn - start_knn).count() / 1e6;
+
+        ostringstream fan;
+        fan << fixed << setprecision(1) << (double)range_fan_out / QUERIES << "/"
+            << (double)knn_fan_out / QUERIES;
+
+        cout << setw(8) << numShards
+             << setw(16) << fixed << setprecision(0) << N / max(1e-6, t_insert)
+             << setw(16) << QUERIES / max(1e-6, t_range)
+             << setw(16) << QUERIES / max(1e-6, t_knn)
+             << setw(14) << fan.str()
+             << setw(16) << largest << endl;
+    }
+    cout << setprecision(3);
+
+    cout << "\n" << Color::CYAN << "  Fan-out = shards contactados por consulta (rango/kNN)" << Color::RESET << endl;
+    if (all_passed) {
+        printSuccess("Resultados del coordinador coinciden con el octree local");
+    } else {
+        printError("El coordinador no coincide con el octree local - Revisar enrutamiento");
+    }
+
+    // Un numero de shards que no divide los 8 octantes debe rechazarse sin crear procesos
+    bool rejected = true;
+    for (int invalid : {0, 3, 16}) {
+        ShardCoordinator coordinator(world_bounds, invalid);
+        rejected = rejected && !coordinator.started();
+    }
+    if (rejected) {
+        printSuccess("Numero de shards invalido rechazado (0, 3, 16)");
+    } else {
+        printError("El coordinador acepto un numero de shards invalido");
+    }
+#endif
+}
+
+// Memoria aproximada de un OctreeNode (nodos + capacidad de los vectores)
+size_t octreeMemoryBytes(const OctreeNode* node) {
+    size_t bytes = sizeof(OctreeNode) + node->points.capacity() * sizeof(Point);
+    for (int i = 0; i < 8; ++i) {
+        if (node->children[i]) bytes += octreeMemoryBytes(node->children[i].get());
+    }
+    return bytes;
+}
+
+void scenario11_MortonDescent() {
+    printHeader("ESCENARIO 11: DESCENSO ENTERO POR LLAVE MORTON");
+
+    Point min_world(0.0, 0.0, 0.0);
+    Point max_world(100.0, 100.0, 100.0);
+    BoundingBox world_bounds(min_world, max_world);
+
+    const int QUERIES = 200;
+    vector<int> testSizes = {200000, 1000000};
     bool all_passed = true;
 
-    for (size_t i = 0; i < test_ranges.size(); ++i) {
-        BoundingBox range(test_ranges[i].first, test_ranges[i].second);
+    cout << Color::BOLD << "\nOctreeNode (puntos medios en double) vs MortonOctree (bits de la llave):\n"
+         << Color::RESET;
+    cout << setw(10) << "N" << setw(12) << "Arbol" << setw(14) << "Insert(ms)" << setw(14) << "Ubicar(ms)"
+         << setw(14) << "Rango(ms)" << setw(10) << "Nodos" << setw(12) << "B/nodo" << setw(12) << "Mem(MB)" << endl;
+    cout << string(98, '-') << endl;
+
+    for (int N : testSizes) {
+        vector<Point> all_points;
+        all_points.reserve(N);
+        for (int i = 0; i < N; ++i) {
+            double x = (double)rand() / RAND_MAX * 100.0;
+            double y = (double)rand() / RAND_MAX * 100.0;
+            double z = (double)rand() / RAND_MAX * 100.0;
+            all_points.push_back(Point(x, y, z));
+        }
+
+        vector<BoundingBox> ranges;
+        for (int i = 0; i < QUERIES; ++i) {
+            double x = (double)rand() / RAND_MAX * 80.0;
+            double y = (double)rand() / RAND_MAX * 80.0;
+            double z = (double)rand() / RAND_MAX * 80.0;
+            ranges.push_back(BoundingBox(Point(x, y, z), Point(x + 20.0, y + 20.0, z + 20.0)));
+        }
 
-        vector<Point> octree_result;
-        vector<Point> naive_result;
+        // Arbol original
+        OctreeNode root(world_bounds, 0);
+        auto start_insert = high_resolution_clock::now();
+        for (const auto& p : all_points) root.insert(p);
+        auto end_insert = high_resolution_clock::now();
+
+        size_t located = 0;
+        auto start_locate = high_resolution_clock::now();
+        for (const auto& p : all_points) located += root.findLeaf(p) != nullptr;
+        auto end_locate = high_resolution_clock::now();
+
+        vector<vector<Point>> float_results(QUERIES);
+        auto start_range = high_resolution_clock::now();
+        for (int i = 0; i < QUERIES; ++i) root.rangeQuery(ranges[i], float_results[i]);
+        auto end_range = high_resolution_clock::now();
+
+        // Arbol con llave Morton
+        MortonOctree morton(world_bounds);
+        auto start_m_insert = high_resolution_clock::now();
+        for (const auto& p : all_points) morton.insert(p);
+        auto end_m_insert = high_resolution_clock::now();
+
+        size_t m_located = 0;
+        int leafDepth = 0;
+        auto start_m_locate = high_resolution_clock::now();
+        for (const auto& p : all_points) m_located += morton.findLeaf(p, leafDepth) != nullptr;
+        auto end_m_locate = high_resolution_clock::now();
+
+        vector<vector<Point>> morton_results(QUERIES);
+        auto start_m_range = high_resolution_clock::now();
+        for (int i = 0; i < QUERIES; ++i) morton.rangeQuery(ranges[i], morton_results[i]);
+        auto end_m_range = high_resolution_clock::now();
+
+        for (int i = 0; i < QUERIES; ++i) {
+            all_passed = all_passed && validateResults(float_results[i], morton_results[i]);
+        }
+        all_passed = all_passed && located == all_points.size() && m_located == all_points.size();
 
-        root.rangeQuery(range, octree_result);
+        int totalNodes = 0, leafNodes = 0, maxDepth = 0, totalPoints = 0;
+        root.getStats(totalNodes, leafNodes, maxDepth, totalPoints);
+        int m_totalNodes = 0, m_leafNodes = 0, m_maxDepth = 0, m_totalPoints = 0;
+        morton.getStats(m_totalNodes, m_leafNodes, m_maxDepth, m_totalPoints);
+        all_passed = all_passed && totalPoints == m_totalPoints;
+
+        cout << setw(10) << N << setw(12) << "OctreeNode"
+             << setw(14) << fixed << setprecision(2)
+             << duration_cast<microseconds>(end_insert - start_insert).count() / 1000.0
+             << setw(14) << duration_cast<microseconds>(end_locate - start_locate).count() / 1000.0
+             << setw(14) << duration_cast<microseconds>(end_range - start_range).count() / 1000.0
+             << setw(10) << totalNodes << setw(12) << sizeof(OctreeNode)
+             << setw(12) << octreeMemoryBytes(&root) / (1024.0 * 1024.0) << endl;
+        cout << setw(10) << "" << setw(12) << "Morton"
+             << setw(14) << duration_cast<microseconds>(end_m_insert - start_m_insert).count() / 1000.0
+             << setw(14) << duration_cast<microseconds>(end_m_locate - start_m_locate).count() / 1000.0
+             << setw(14) << duration_cast<microseconds>(end_m_range - start_m_range).count() / 1000.0
+             << setw(10) << m_totalNodes << setw(12) << sizeof(MortonOctree::Node)
+             << setw(12) << morton.memoryBytes() / (1024.0 * 1024.0) << endl;
+    }
+    cout << setprecision(3);
 
-        for (const auto& p : all_points) {
-            if (range.contains(p)) {
-                naive_result.push_back(p);
+    // Puntos exactamente sobre los planos de division y en las esquinas
+    {
+        printSubHeader("Puntos sobre los puntos medios y esquinas");
+        MortonOctree morton(world_bounds);
+        vector<Point> edge_points;
+        for (double x : {0.0, 25.0, 50.0, 75.0, 100.0}) {
+            for (double y : {0.0, 50.0, 100.0}) {
+                for (double z : {0.0, 12.5, 50.0, 100.0}) {
+                    edge_points.push_back(Point(x, y, z));
+                }
             }
         }
+        for (const auto& p : edge_points) morton.insert(p);
+
+        bool bounds_ok = true;
+        for (const auto& p : edge_points) {
+            int depth = 0;
+            if (!morton.findLeaf(p, depth)) {
+                bounds_ok = false;
+                continue;
+            }
+            uint64_t prefix = morton.mortonKey(p) >> (3 * (MORTON_BITS - depth));
+            bounds_ok = bounds_ok && morton.nodeBounds(depth, prefix).contains(p);
+        }
 
-        bool passed = validateResults(octree_result, naive_result);
-
-        cout << "Prueba " << (i + 1) << " - Rango ["
-             << (int)test_ranges[i].first.x << "-" << (int)test_ranges[i].second.x << "]: ";
+        vector<Point> everything;
+        morton.rangeQuery(world_bounds, everything);
+        bool count_ok = everything.size() == edge_points.size();
 
-        if (passed) {
-            printSuccess("CORRECTO (" + to_string(octree_result.size()) + " puntos)");
+        if (bounds_ok && count_ok) {
+            printSuccess("Los " + to_string(edge_points.size()) +
+                         " puntos de borde caen en la hoja cuyos limites implicitos los contienen");
         } else {
-            printError("FALLO (Octree: " + to_string(octree_result.size()) +
-                      ", Naive: " + to_string(naive_result.size()) + ")");
-            all_passed = false;
+            printError("Puntos de borde mal ubicados");
         }
+        all_passed = all_passed && bounds_ok && count_ok;
     }
 
     cout << "\n";
     if (all_passed) {
-        printSuccess("TODAS LAS PRUEBAS PASARON - Implementacion correcta!");
+        printSuccess("MortonOctree devuelve los mismos resultados que OctreeNode");
     } else {
-        printError("Algunas pruebas fallaron - Revisar implementacion");
+        printError("MortonOctree no coincide con OctreeNode - Revisar cuantizacion");
     }
 }
 
-void scenario4_EdgeCases() {
-    printHeader("ESCENARIO 4: CASOS BORDE Y EXTREMOS");
+void scenario12_AutoTuner() {
+    printHeader("ESCENARIO 12: AJUSTE AUTOMATICO DE THRESHOLD Y MAX_DEPTH");
 
     Point min_world(0.0, 0.0, 0.0);
     Point max_world(100.0, 100.0, 100.0);
     BoundingBox world_bounds(min_world, max_world);
 
-    // Test 1: Octree vacio
-    {
-        printSubHeader("Test 1: Consulta en Octree vacio");
-        OctreeNode root(world_bounds, 0);
-        vector<Point> result;
-        BoundingBox range(Point(40, 40, 40), Point(60, 60, 60));
-        root.rangeQuery(range, result);
+    const int N = 500000;
+    const int QUERIES = 300;
+    const size_t SAMPLE = 50000;
+    const int REGION_DEPTH = 2;
+
+    auto uniform = [](double lo, double hi) { return lo + (double)rand() / RAND_MAX * (hi - lo); };
+    const double PI = acos(-1.0);     // M_PI no es estandar (MinGW en modo estricto)
+    auto gaussian = [&uniform, PI]() {
+        double u1 = max(1e-12, uniform(0.0, 1.0));
+        double u2 = uniform(0.0, 1.0);
+        return sqrt(-2.0 * log(u1)) * cos(2.0 * PI * u2);
+    };
+    auto clampWorld = [](double v) { return max(0.0, min(100.0, v)); };
+
+    // Datos agrupados: 6 cumulos gaussianos, una region muy densa como en el
+    // escenario 4 y fondo uniforme
+    vector<Point> centers;
+    vector<double> sigmas;
+    for (int c = 0; c < 6; ++c) {
+        centers.push_back(Point(uniform(15, 85), uniform(15, 85), uniform(15, 85)));
+        sigmas.push_back(uniform(1.0, 5.0));
+    }
 
-        if (result.empty()) {
-            printSuccess("Octree vacio retorna 0 puntos");
+    vector<Point> data;
+    data.reserve(N);
+    for (int i = 0; i < N; ++i) {
+        double r = uniform(0.0, 1.0);
+        if (r < 0.6) {
+            int c = rand() % centers.size();
+            data.push_back(Point(clampWorld(centers[c].x + gaussian() * sigmas[c]),
+                                 clampWorld(centers[c].y + gaussian() * sigmas[c]),
+                                 clampWorld(centers[c].z + gaussian() * sigmas[c])));
+        } else if (r < 0.8) {
+            data.push_back(Point(uniform(49, 51), uniform(49, 51), uniform(49, 51)));
         } else {
-            printError("Error: Octree vacio retorno " + to_string(result.size()) + " puntos");
+            data.push_back(Point(uniform(0, 100), uniform(0, 100), uniform(0, 100)));
         }
     }
 
-    // Test 2: Puntos en las esquinas
-    {
-        printSubHeader("Test 2: Puntos en esquinas del espacio");
-        OctreeNode root(world_bounds, 0);
-        vector<Point> corners = {
-            Point(0, 0, 0), Point(100, 0, 0), Point(0, 100, 0), Point(0, 0, 100),
-            Point(100, 100, 0), Point(100, 0, 100), Point(0, 100, 100), Point(100, 100, 100)
-        };
-
-        for (const auto& p : corners) {
-            root.insert(p);
-        }
-
-        printSuccess("Insertadas 8 esquinas correctamente");
-
-        // Consulta que deberia incluir todas las esquinas
-        vector<Point> result;
-        root.rangeQuery(world_bounds, result);
-
-        if (result.size() == 8) {
-            printSuccess("Consulta completa retorno todas las esquinas");
+    // Traza registrada: la mayoria de consultas alrededor de los cumulos
+    vector<BoundingBox> trace;
+    for (int i = 0; i < QUERIES; ++i) {
+        Point c;
+        double h;
+        if (uniform(0.0, 1.0) < 0.7) {
+            const Point& base = centers[rand() % centers.size()];
+            c = Point(base.x + uniform(-3, 3), base.y + uniform(-3, 3), base.z + uniform(-3, 3));
+            h = uniform(1.0, 5.0);
         } else {
-            printError("Error: Se esperaban 8 puntos, se obtuvieron " + to_string(result.size()));
+            c = Point(uniform(0, 100), uniform(0, 100), uniform(0, 100));
+            h = uniform(5.0, 15.0);
         }
+        trace.push_back(BoundingBox(Point(c.x - h, c.y - h, c.z - h), Point(c.x + h, c.y + h, c.z + h)));
     }
 
-    // Test 3: Alta densidad localizada
-    {
-        printSubHeader("Test 3: Alta densidad en region localizada");
-        OctreeNode root(world_bounds, 0);
-
-        int dense_points = 10000;
-        for (int i = 0; i < dense_points; ++i) {
-            double x = 49.0 + (double)rand() / RAND_MAX * 2.0;  // [49, 51]
-            double y = 49.0 + (double)rand() / RAND_MAX * 2.0;
-            double z = 49.0 + (double)rand() / RAND_MAX * 2.0;
-            root.insert(Point(x, y, z));
-        }
+    printInfo("N = " + to_string(N) + " (agrupados), traza de " + to_string(QUERIES) +
+              " consultas, muestra de " + to_string(SAMPLE) + " puntos");
 
-        int totalNodes = 0, leafNodes = 0, maxDepth = 0, totalPoints = 0;
-        root.getStats(totalNodes, leafNodes, maxDepth, totalPoints);
+    auto start_tune = high_resolution_clock::now();
+    OctreeTuner tuner(world_bounds, data, SAMPLE);
+    tuner.calibrate(data, trace);
+    TuningResult tuning = tuner.tune(trace, REGION_DEPTH);
+    auto end_tune = high_resolution_clock::now();
 
-        cout << Color::CYAN << "  Puntos insertados: " << totalPoints << endl;
-        cout << "  Nodos creados: " << totalNodes << endl;
-        cout << "  Profundidad maxima: " << maxDepth << Color::RESET << endl;
+    cout << Color::CYAN << "  Costo calibrado: " << fixed << setprecision(2) << tuner.nodeCostNs()
+         << " ns/nodo, " << tuner.pointCostNs() << " ns/punto" << endl;
+    cout << "  Tiempo de ajuste: " << duration_cast<milliseconds>(end_tune - start_tune).count()
+         << " ms" << Color::RESET << endl;
 
-        printSuccess("Octree manejo correctamente alta densidad localizada");
+    int minT = numeric_limits<int>::max(), maxT = 0, minD = numeric_limits<int>::max(), maxD = 0;
+    for (const auto& r : tuning.regions) {
+        minT = min(minT, r.threshold); maxT = max(maxT, r.threshold);
+        minD = min(minD, r.maxDepth); maxD = max(maxD, r.maxDepth);
     }
-}
-
-void scenario5_Interactive() {
-    printHeader("ESCENARIO 5: MODO INTERACTIVO");
-
-    Point min_world(0.0, 0.0, 0.0);
-    Point max_world(100.0, 100.0, 100.0);
-    BoundingBox world_bounds(min_world, max_world);
-    OctreeNode root(world_bounds, 0);
-    vector<Point> all_points;
-
-    bool running = true;
 
-    while (running) {
-        cout << "\n" << Color::BOLD << Color::MAGENTA;
-        cout << "======== MENU INTERACTIVO ========" << endl;
-        cout << "1. Insertar puntos aleatorios" << endl;
-        cout << "2. Insertar punto manual" << endl;
-        cout << "3. Realizar consulta por rango" << endl;
-        cout << "4. Ver estadisticas del Octree" << endl;
-        cout << "5. Visualizar proyeccion 2D" << endl;
-        cout << "6. Limpiar Octree" << endl;
-        cout << "0. Volver al menu principal" << endl;
-        cout << "==================================" << Color::RESET << endl;
-        cout << "Opcion: ";
+    struct Variant {
+        string name;
+        string params;
+        unique_ptr<OctreeNode> root;
+        double predictedUs;
+    };
 
-        int opcion;
-        cin >> opcion;
+    TuningResult defaults = tuning;
+    defaults.threshold = THRESHOLD;
+    defaults.maxDepth = MAX_DEPTH;
+
+    vector<Variant> variants;
+    variants.push_back({"Por defecto", "T=" + to_string(THRESHOLD) + " D=" + to_string(MAX_DEPTH),
+                        OctreeTuner::build(world_bounds, data, defaults, false), tuning.defaultPredictedUs});
+    variants.push_back({"Global", "T=" + to_string(tuning.threshold) + " D=" + to_string(tuning.maxDepth),
+                        OctreeTuner::build(world_bounds, data, tuning, false), tuning.predictedUs});
+    variants.push_back({"Por region", "T=" + to_string(minT) + ".." + to_string(maxT) +
+                        " D=" + to_string(minD) + ".." + to_string(maxD),
+                        OctreeTuner::build(world_bounds, data, tuning, true), tuning.adaptivePredictedUs});
+
+    cout << Color::BOLD << "\nCosto de la traza: predicho vs medido:\n" << Color::RESET;
+    cout << setw(13) << "Config" << setw(18) << "Parametros" << setw(10) << "Nodos"
+         << setw(12) << "Hoja max" << setw(15) << "Predicho(ms)" << setw(14) << "Medido(ms)"
+         << setw(10) << "Error" << endl;
+    cout << string(92, '-') << endl;
 
-        if (cin.fail()) {
-            cin.clear();
-            cin.ignore(10000, '\n');
-            printError("Opcion invalida");
-            continue;
+    bool all_passed = true;
+    vector<vector<Point>> expected(trace.size());
+    for (size_t i = 0; i < trace.size(); ++i) variants[0].root->rangeQuery(trace[i], expected[i]);
+
+    for (auto& v : variants) {
+        double best = numeric_limits<double>::infinity();
+        for (int rep = 0; rep < 3; ++rep) {
+            vector<Point> result;
+            auto start = high_resolution_clock::now();
+            for (const auto& range : trace) {
+                result.clear();
+                v.root->rangeQuery(range, result);
+            }
+            auto end = high_resolution_clock::now();
+            best = min(best, (double)duration_cast<microseconds>(end - start).count());
         }
 
-        switch(opcion) {
-            case 1: {
-                int n;
-                cout << "Cantidad de puntos a insertar: ";
-                cin >> n;
-
-                if (n > 0 && n <= 1000000) {
-                    printInfo("Insertando " + to_string(n) + " puntos...");
-                    auto start = high_resolution_clock::now();
-
-                    for (int i = 0; i < n; ++i) {
-                        double x = (double)rand() / RAND_MAX * 100.0;
-                        double y = (double)rand() / RAND_MAX * 100.0;
-                        double z = (double)rand() / RAND_MAX * 100.0;
-                        Point p(x, y, z);
-                        all_points.push_back(p);
-                        root.insert(p);
-                    }
+        for (size_t i = 0; i < trace.size(); i += 25) {
+            vector<Point> result;
+            v.root->rangeQuery(trace[i], result);
+            all_passed = all_passed && validateResults(result, expected[i]);
+        }
 
-                    auto end = high_resolution_clock::now();
-                    auto time_ms = duration_cast<milliseconds>(end - start).count();
+        int totalNodes = 0, leafNodes = 0, maxDepth = 0, totalPoints = 0;
+        v.root->getStats(totalNodes, leafNodes, maxDepth, totalPoints);
+        all_passed = all_passed && totalPoints == N;
+
+        double error = (v.predictedUs - best) / max(1.0, best) * 100.0;
+        cout << setw(13) << v.name << setw(18) << v.params << setw(10) << totalNodes
+             << setw(12) << largestLeaf(v.root.get())
+             << setw(15) << setprecision(2) << v.predictedUs / 1000.0
+             << setw(14) << best / 1000.0
+             << setw(9) << setprecision(1) << error << "%" << endl;
+    }
+    cout << setprecision(3);
 
-                    printSuccess("Puntos insertados en " + to_string(time_ms) + " ms");
-                } else {
-                    printError("Cantidad invalida");
-                }
-                break;
-            }
+    cout << "\n";
+    if (all_passed) {
+        printSuccess("Los arboles ajustados devuelven los mismos resultados que la configuracion por defecto");
+    } else {
+        printError("Los arboles ajustados no coinciden - Revisar construccion");
+    }
+}
 
-            case 2: {
-                double x, y, z;
-                cout << "Ingrese coordenadas (x y z): ";
-                cin >> x >> y >> z;
+// Celda de la tabla de perfilado: valor por unidad o "-" si no hay contador
+string perfCell(const PerfSample& s, int id, double units, int precision) {
+    if (!s.valid[id] || units <= 0) return "-";
+    ostringstream out;
+    out << fixed << setprecision(precision) << s.value[id] / units;
+    return out.str();
+}
 
-                if (x >= 0 && x <= 100 && y >= 0 && y <= 100 && z >= 0 && z <= 100) {
-                    Point p(x, y, z);
-                    all_points.push_back(p);
-                    root.insert(p);
-                    printSuccess("Punto (" + to_string(x) + ", " + to_string(y) + ", " + to_string(z) + ") insertado");
-                } else {
-                    printError("Coordenadas fuera de rango [0, 100]");
-                }
-                break;
-            }
+void printPerfRow(const string& phase, size_t ops, size_t points, const PerfSample& s) {
+    string ipc = "-";
+    if (s.valid[PERF_CYCLES] && s.valid[PERF_INSTRUCTIONS] && s.value[PERF_CYCLES] > 0) {
+        ostringstream out;
+        out << fixed << setprecision(2) << s.value[PERF_INSTRUCTIONS] / s.value[PERF_CYCLES];
+        ipc = out.str();
+    }
 
-            case 3: {
-                double x1, y1, z1, x2, y2, z2;
-                cout << "Ingrese rango minimo (x y z): ";
-                cin >> x1 >> y1 >> z1;
-                cout << "Ingrese rango maximo (x y z): ";
-                cin >> x2 >> y2 >> z2;
+    cout << setw(20) << phase << setw(9) << ops << setw(10) << points
+         << setw(11) << fixed << setprecision(1) << s.ns / max<size_t>(1, ops)
+         << setw(12) << perfCell(s, PERF_CYCLES, (double)ops, 0)
+         << setw(7) << ipc
+         << setw(10) << perfCell(s, PERF_LLC_MISSES, (double)ops, 2)
+         << setw(10) << perfCell(s, PERF_BRANCH_MISSES, (double)ops, 2)
+         << setw(10) << setprecision(2) << s.ns / max<size_t>(1, points)
+         << setw(10) << perfCell(s, PERF_LLC_MISSES, (double)points, 3) << endl;
+}
 
-                BoundingBox range(Point(x1, y1, z1), Point(x2, y2, z2));
-                vector<Point> result;
+void scenario13_PerfProfile() {
+    printHeader("ESCENARIO 13: PERFILADO CON CONTADORES DE HARDWARE");
 
-                auto start = high_resolution_clock::now();
-                root.rangeQuery(range, result);
-                auto end = high_resolution_clock::now();
-                auto time_us = duration_cast<microseconds>(end - start).count();
+    Point min_world(0.0, 0.0, 0.0);
+    Point max_world(100.0, 100.0, 100.0);
+    BoundingBox world_bounds(min_world, max_world);
 
-                printSuccess("Consulta completada en " + to_string(time_us) + " microsegundos");
-                printInfo("Puntos encontrados: " + to_string(result.size()));
+    const int QUERIES = 1000;
+    const int K = 10;
 
-                if (result.size() <= 10) {
-                    for (const auto& p : result) {
-                        cout << "  (" << p.x << ", " << p.y << ", " << p.z << ")" << endl;
-                    }
-                }
-                break;
-            }
+    PerfProfiler profiler;
+    if (profiler.anyAvailable()) {
+        string names;
+        for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+            names += string(PERF_COUNTER_NAMES[i]) + (profiler.counterAvailable(i) ? " [si]" : " [no]");
+            if (i + 1 < PERF_COUNTER_COUNT) names += ", ";
+        }
+        printInfo("Contadores: " + names);
+    } else {
+        printWarning("Contadores de hardware no disponibles (perf_event_paranoid, VM sin PMU o no Linux): solo tiempo");
+    }
 
-            case 4: {
-                int totalNodes = 0, leafNodes = 0, maxDepth = 0, totalPoints = 0;
-                root.getStats(totalNodes, leafNodes, maxDepth, totalPoints);
+    vector<int> testSizes = {200000, 1000000};
 
-                cout << "\n" << Color::CYAN << Color::BOLD << "ESTADISTICAS DEL OCTREE:" << Color::RESET << endl;
-                cout << Color::CYAN;
-                cout << "  Total de nodos: " << totalNodes << endl;
-                cout << "  Nodos hoja: " << leafNodes << endl;
-                cout << "  Nodos internos: " << (totalNodes - leafNodes) << endl;
-                cout << "  Profundidad maxima: " << maxDepth << endl;
-                cout << "  Puntos almacenados: " << totalPoints << endl;
-                cout << "  Factor de ramificacion promedio: "
-                     << fixed << setprecision(2)
-                     << (leafNodes > 0 ? (double)totalPoints / leafNodes : 0.0) << Color::RESET << endl;
-                break;
-            }
+    for (int N : testSizes) {
+        vector<Point> all_points;
+        all_points.reserve(N);
+        for (int i = 0; i < N; ++i) {
+            double x = (double)rand() / RAND_MAX * 100.0;
+            double y = (double)rand() / RAND_MAX * 100.0;
+            double z = (double)rand() / RAND_MAX * 100.0;
+            all_points.push_back(Point(x, y, z));
+        }
 
-            case 5: {
-                if (all_points.empty()) {
-                    printWarning("No hay puntos para visualizar");
-                } else {
-                    draw2DProjection(&root, all_points);
-                }
-                break;
-            }
+        vector<BoundingBox> ranges;
+        vector<Point> knn_points;
+        for (int i = 0; i < QUERIES; ++i) {
+            double x = (double)rand() / RAND_MAX * 90.0;
+            double y = (double)rand() / RAND_MAX * 90.0;
+            double z = (double)rand() / RAND_MAX * 90.0;
+            ranges.push_back(BoundingBox(Point(x, y, z), Point(x + 10.0, y + 10.0, z + 10.0)));
+            knn_points.push_back(Point((double)rand() / RAND_MAX * 100.0,
+                                       (double)rand() / RAND_MAX * 100.0,
+                                       (double)rand() / RAND_MAX * 100.0));
+        }
 
-            case 6: {
-                root = OctreeNode(world_bounds, 0);
-                all_points.clear();
-                printSuccess("Octree limpiado");
-                break;
-            }
+        cout << Color::BOLD << "\nN = " << N << " (por operacion y por punto procesado):\n" << Color::RESET;
+        cout << setw(20) << "Fase" << setw(9) << "Ops" << setw(10) << "Puntos"
+             << setw(11) << "ns/op" << setw(12) << "ciclos/op" << setw(7) << "IPC"
+             << setw(10) << "LLC/op" << setw(10) << "Salto/op"
+             << setw(10) << "ns/pt" << setw(10) << "LLC/pt" << endl;
+        cout << string(109, '-') << endl;
 
-            case 0: {
-                running = false;
-                break;
-            }
+        // OctreeNode: construccion, consultas por rango y kNN
+        OctreeNode root(world_bounds, 0);
+        profiler.start();
+        for (const auto& p : all_points) root.insert(p);
+        printPerfRow("Octree build", all_points.size(), all_points.size(), profiler.stop());
 
-            default:
-                printError("Opcion invalida");
+        vector<Point> result;
+        size_t found = 0;
+        profiler.start();
+        for (const auto& range : ranges) {
+            result.clear();
+            root.rangeQuery(range, result);
+            found += result.size();
+        }
+        printPerfRow("Octree rangeQuery", ranges.size(), found, profiler.stop());
+
+        found = 0;
+        profiler.start();
+        for (const auto& q : knn_points) {
+            result.clear();
+            root.kNearest(q, K, result);
+            found += result.size();
         }
+        printPerfRow("Octree kNN", knn_points.size(), found, profiler.stop());
+
+        // MortonOctree: mismo trabajo con nodos mas pequenos
+        MortonOctree morton(world_bounds);
+        profiler.start();
+        for (const auto& p : all_points) morton.insert(p);
+        printPerfRow("Morton build", all_points.size(), all_points.size(), profiler.stop());
+
+        found = 0;
+        profiler.start();
+        for (const auto& range : ranges) {
+            result.clear();
+            morton.rangeQuery(range, result);
+            found += result.size();
+        }
+        printPerfRow("Morton rangeQuery", ranges.size(), found, profiler.stop());
     }
+    cout << setprecision(3);
+
+    cout << "\n" << Color::CYAN
+         << "  Puntos = puntos insertados (build) o devueltos (consultas); LLC = fallos de lectura de ultimo nivel"
+         << Color::RESET << endl;
 }
 
 // =============================================================================
@@ -749,6 +4090,14 @@ void showMainMenu() {
     cout << "4. Tests de casos borde" << endl;
     cout << "5. Modo interactivo" << endl;
     cout << "6. Ejecutar DEMO COMPLETA (para exposicion)" << endl;
+    cout << "7. Cursor de consulta paginada (streaming)" << endl;
+    cout << "8. Cache de consultas repetidas" << endl;
+    cout << "9. Submuestreo por voxeles (paralelo)" << endl;
+    cout << "10. Ventana de tiempo deslizante" << endl;
+    cout << "11. Octree distribuido en procesos (shards)" << endl;
+    cout << "12. Descenso entero por llave Morton" << endl;
+    cout << "13. Ajuste automatico de THRESHOLD y MAX_DEPTH" << endl;
+    cout << "14. Perfilado con contadores de hardware" << endl;
     cout << "0. Salir" << endl;
     cout << "================================================" << Color::RESET << endl;
     cout << "\nSeleccione una opcion: ";
@@ -821,6 +4170,30 @@ int main() {
                 scenario4_EdgeCases();
                 printSuccess("\nDEMO COMPLETA FINALIZADA");
                 break;
+            case 7:
+                scenario6_StreamingCursor();
+                break;
+            case 8:
+                scenario7_QueryCache();
+                break;
+            case 9:
+                scenario8_VoxelDownsample();
+                break;
+            case 10:
+                scenario9_SlidingWindow();
+                break;
+            case 11:
+                scenario10_ShardedOctree();
+                break;
+            case 12:
+                scenario11_MortonDescent();
+                break;
+            case 13:
+                scenario12_AutoTuner();
+                break;
+            case 14:
+                scenario13_PerfProfile();
+                break;
             case 0:
                 cout << "\n" << Color::GREEN << "Gracias por usar el proyecto Octree!" << Color::RESET << endl;
                 running = false;